@@ -0,0 +1,122 @@
+/*
+ * chase.h - C interface to the Cat and Mouse game engine (libchase.so).
+ *
+ * Build the library from main.cpp:
+ *   g++ -std=c++17 -O2 -fPIC -shared -fvisibility=hidden -DCHASE_LIBRARY main.cpp \
+ *       -o libchase.so -pthread
+ * The window and OpenGL code is left out of this build, so it needs no GL libraries.
+ *
+ * Every game instance lives in a buffer owned by the caller, chase_state_size() bytes
+ * aligned to chase_state_align(). Instances hold no pointers to library memory, so they
+ * can be copied with chase_clone() (or memcpy), stored, and discarded freely. The engine
+ * runs one instance at a time: calls from several threads are serialized internally.
+ * Functions returning int return CHASE_OK or a negative CHASE_ERROR_* code.
+ */
+#ifndef CHASE_H
+#define CHASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CHASE_EXPORT __declspec(dllexport)
+#else
+#define CHASE_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define CHASE_API_VERSION 1
+
+#define CHASE_OK 0
+#define CHASE_ERROR_INVALID_STATE -1    /* Not created, destroyed, or from another library build. */
+#define CHASE_ERROR_INVALID_ARGUMENT -2
+
+/* Player actions for chase_step(). */
+#define CHASE_ACTION_UP 0
+#define CHASE_ACTION_DOWN 1
+#define CHASE_ACTION_LEFT 2
+#define CHASE_ACTION_RIGHT 3
+#define CHASE_ACTION_STAY 4
+
+/* Cat pathfinders; the predictive one spends wall-clock time and is not deterministic. */
+#define CHASE_PATHFINDER_BFS 0
+#define CHASE_PATHFINDER_JUNCTION 1
+#define CHASE_PATHFINDER_HPA 2
+#define CHASE_PATHFINDER_DSTAR 3
+#define CHASE_PATHFINDER_BIDIRECTIONAL 4
+#define CHASE_PATHFINDER_PREDICTIVE 5
+#define CHASE_PATHFINDER_TABLEBASE 6 /* Reads tablebase_level<N>.cmtb from the working directory. */
+
+/* Ambusher personalities. */
+#define CHASE_AMBUSHER_INTERCEPTOR 0
+#define CHASE_AMBUSHER_FLANKER 1
+#define CHASE_AMBUSHER_PATROLLER 2
+#define CHASE_AMBUSHER_WATCHER 3
+#define CHASE_MAX_AMBUSHERS 4
+
+/* Outcome of a step. */
+#define CHASE_STATUS_PLAYING 0
+#define CHASE_STATUS_CAUGHT 1
+#define CHASE_STATUS_WON 2 /* Cleared the last level. */
+
+typedef struct chase_config {
+    uint32_t seed;         /* Item placement and ambusher wandering; 0 picks a fixed default. */
+    int32_t level;         /* Starting level, 1 to 3. */
+    int32_t pathfinder;    /* CHASE_PATHFINDER_*. */
+    int32_t ambusher_count;
+    int32_t ambushers[CHASE_MAX_AMBUSHERS]; /* CHASE_AMBUSHER_* for the first ambusher_count. */
+    int32_t verbose;       /* Nonzero lets the engine log pickups and captures to stdout. */
+} chase_config;
+
+typedef struct chase_step_result {
+    int32_t status;        /* CHASE_STATUS_*. */
+    int32_t cheese;        /* Cheese collected during the step. */
+    int32_t level_cleared; /* Nonzero if a level was cleared; the next one is already loaded. */
+} chase_step_result;
+
+typedef struct chase_info {
+    int32_t level, score, total_score;
+    int32_t player_x, player_y, cat_x, cat_y;
+    int32_t cheese_left;
+    int32_t cat_delay_ms;
+    int32_t cat_slowed;
+    int32_t status;        /* CHASE_STATUS_*. */
+    uint64_t hash;         /* Zobrist hash of the game state. */
+} chase_info;
+
+CHASE_EXPORT int chase_api_version(void);
+CHASE_EXPORT size_t chase_state_size(void);
+CHASE_EXPORT size_t chase_state_align(void);
+CHASE_EXPORT void chase_default_config(chase_config* config);
+
+/* Starts a new game in `state` with the given configuration (NULL for the defaults). */
+CHASE_EXPORT int chase_create(void* state, const chase_config* config);
+/* Starts a new game with the instance's configuration and a new seed. */
+CHASE_EXPORT int chase_reset(void* state, uint32_t seed);
+/* Applies a player action, then advances the game clock by elapsed_ms, moving the cat
+   whenever its delay runs out. A cleared level immediately loads the next one. */
+CHASE_EXPORT int chase_step(void* state, int action, int elapsed_ms, chase_step_result* result);
+/* Steps `count` instances; actions[i] and results[i] belong to states[i]. Instances are
+   visited grouped by level so layouts are not reloaded between neighbours. */
+CHASE_EXPORT int chase_step_batch(void* const* states, int count, const int* actions, int elapsed_ms, chase_step_result* results);
+CHASE_EXPORT int chase_clone(void* dst, const void* src);
+/* Invalidates the instance. The buffer itself stays the caller's to free. */
+CHASE_EXPORT void chase_destroy(void* state);
+CHASE_EXPORT int chase_get_info(const void* state, chase_info* info);
+
+/* Observations: chase_observation_size() bytes of uint8 planes (walls, cheese, power-ups,
+   player, cat, ambushers; each rows * cols) followed by the scalars cat delay / 4 ms,
+   slowed, level and cheese left. Encoding into the same buffer as the previous call for
+   this instance only rewrites the cells that changed. */
+CHASE_EXPORT size_t chase_observation_size(void);
+CHASE_EXPORT void chase_grid_size(int* rows, int* cols);
+CHASE_EXPORT int chase_observe(void* state, uint8_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHASE_H */
@@ -21,9 +21,13 @@
  * game state management, and basic AI in C++.
  */
 
-#include <GL/glut.h>
+#ifndef CHASE_LIBRARY
+#include <GL/glut.h> // The library build opens no window and links no GL.
+#endif
 #include <iostream>
 #include <queue>
+#include <deque>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -32,6 +36,41 @@
 #include <utility>
 #include <cmath>
 #include <algorithm>
+#include <climits>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <filesystem>
+#include "chase.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#endif
 
 // --- Game & Window Configuration ---
 const int ROWS = 23;
@@ -39,7 +78,6 @@ const int COLS = 23;
 const int CELL_SIZE = 25;
 const int WINDOW_WIDTH = COLS * CELL_SIZE;
 const int WINDOW_HEIGHT = ROWS * CELL_SIZE;
-const int TUNNEL_ROW_INDEX = 11; // The Y-index for the horizontal tunnel.
 
 // --- Maze Tile Definitions ---
 const int TILE_WALL = 1;
@@ -47,6 +85,12 @@ const int TILE_PATH = 0;
 const int TILE_BLOCKED = 3; // Unused in current logic, but available.
 const int TILE_SLOW_POWERUP = 4;
 
+// --- Movement Directions ---
+enum Direction { DIR_UP, DIR_DOWN, DIR_LEFT, DIR_RIGHT };
+const int DIR_DX[] = {0, 0, -1, 1};
+const int DIR_DY[] = {-1, 1, 0, 0};
+const Direction DIR_OPPOSITE[] = {DIR_DOWN, DIR_UP, DIR_RIGHT, DIR_LEFT};
+
 // --- Gameplay Constants ---
 const int PLAYER_START_X = 1;
 const int PLAYER_START_Y = 1;
@@ -58,37 +102,170 @@ const int NUM_POWERUPS_PER_LEVEL = 1;
 
 // --- Game State Management ---
 enum GameState { INTRO, START_MENU, PLAYING, PAUSED, GAME_OVER, GAME_WON_LEVEL, GAME_WON_FINAL };
-GameState currentGameState = INTRO;
 
 // --- Dynamic Game Variables ---
-int playerX = PLAYER_START_X;
-int playerY = PLAYER_START_Y;
-int catX = CAT_START_X;
-int catY = CAT_START_Y;
 int maze[ROWS][COLS];
-int currentLevel = 1;
-int score = 0;
-int totalScore = 0;
-int initialCheeseCount = 0;
-std::vector<std::pair<int, int>> cheeseLocations;
 
-// Power-up structure and storage
+// A two-way portal: stepping out of (x, y) towards dir lands on (toX, toY), and stepping
+// out of (toX, toY) in the opposite direction leads back. Covers edge wrap-around tunnels
+// (horizontal or vertical) as well as teleporters between any two path cells.
+struct Portal {
+    int x, y;
+    Direction dir;
+    int toX, toY;
+};
+std::vector<Portal> levelPortals;
+
+// The maze compiled into compressed sparse row (CSR) adjacency at level load.
+// Cells are indexed as y * width + x. Neighbors of a cell c are
+// targets[offsets[c]] .. targets[offsets[c + 1] - 1]; moves[c * 4 + dir] is the cell
+// reached by stepping in a direction, or c itself if that way is blocked.
+struct MazeGraph {
+    int width = 0, height = 0;
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> moves;
+    std::vector<bool> walkable;
+};
+MazeGraph mazeGraph;
+int loadedMazeLevel = 0; // Level whose layout is in maze[][], or 0 if none yet.
+
+// Power-up structure
 struct Powerup {
     int x, y;
     int type = TILE_SLOW_POWERUP;
     float sparklePhase = 0.0f;
 };
-std::vector<Powerup> powerupLocations;
-bool isCatSlowed = false;
-int catSlowDurationTimer = 0;
 const int CAT_SLOW_DURATION_MS = 5000;
 
 // Cat speed logic
 const int INITIAL_CAT_DELAY_MS = 350;
 const int MIN_CAT_DELAY_MS = 150;
 const int DELAY_REDUCTION_PER_CHEESE = (NUM_CHEESE_TO_PLACE > 1) ? ((INITIAL_CAT_DELAY_MS - MIN_CAT_DELAY_MS) / (NUM_CHEESE_TO_PLACE - 1)) : 0;
-int currentCatDelay = INITIAL_CAT_DELAY_MS;
-int normalCatDelayBeforeSlowdown = 0;
+
+// The cat's delay eases from initialDelayMs to minDelayMs as cheese is collected. Each level
+// can override the defaults with a tuned curve from DIFFICULTY_FILE (see --tune-difficulty).
+struct CatSpeedCurve {
+    int initialDelayMs = INITIAL_CAT_DELAY_MS;
+    int minDelayMs = MIN_CAT_DELAY_MS;
+    float exponent = 0.5f; // 0.5 is the original square-root curve.
+};
+const char* const DIFFICULTY_FILE = "difficulty.cfg";
+CatSpeedCurve levelSpeedCurves[MAX_LEVELS + 1];
+
+// Pathfinding selection and instrumentation
+enum CatPathfinder { PATHFINDER_BFS, PATHFINDER_JUNCTION, PATHFINDER_HPA, PATHFINDER_DSTAR, PATHFINDER_BIDIRECTIONAL, PATHFINDER_PREDICTIVE, PATHFINDER_TABLEBASE, PATHFINDER_PLAYER };
+CatPathfinder catPathfinder = PATHFINDER_JUNCTION;
+int playerCatHeading = -1; // PATHFINDER_PLAYER: the direction a second player steers the cat, or -1 to stand.
+int lastSearchNodesTouched = 0; // Nodes expanded by the most recent chaser search.
+
+// Extra chasers with ambush personalities, moving alongside the main cat
+enum ChaserPersonality { PERSONALITY_INTERCEPTOR, PERSONALITY_FLANKER, PERSONALITY_PATROLLER, PERSONALITY_WATCHER, PERSONALITY_COUNT };
+const char* const PERSONALITY_NAMES[PERSONALITY_COUNT] = {"interceptor", "flanker", "patroller", "watcher"}; // As given to --ambushers.
+const int MAX_AMBUSHERS = 4;
+struct Ambusher {
+    int x, y;
+    ChaserPersonality personality;
+    int goal = -1; // Current patrol cell, kept until reached so patrols do not dither.
+};
+std::vector<ChaserPersonality> ambusherPersonalities; // Chosen on the command line.
+bool optimizeItemPlacement = false;  // --placement=optimized: search for balanced item layouts.
+bool engineLog = true;               // Console messages for level loads, pickups and captures; off in headless runs.
+bool showSafeRouteHint = false;      // Toggled with 'H': draws the safest route to cheese.
+bool viewingReplay = false;          // --replay=<file>: the window scrubs a recording instead of playing.
+bool networkClient = false;          // --connect=<address>: the window shows a game run by a server.
+bool versusMode = false;             // --versus=...: a second player steers the cat from another process.
+std::vector<int> safeRoute;          // Cells from the player's next step to that cheese.
+
+// --- Game State Block ---
+// Everything a running game needs lives in one trivially copyable struct, so saving or
+// restoring a game (for search, rollback or replay seeking) is a single memcpy. The
+// familiar globals below are references into it, so gameplay code reads as before.
+// Derived data (the compiled maze, pathfinder caches) is rebuilt from the level number.
+
+// A fixed-capacity list with the parts of the std::vector interface the game uses.
+template <typename T, int Capacity>
+struct FixedList {
+    T items[Capacity];
+    int count = 0;
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+    void push_back(const T& item) { if (count < Capacity) items[count++] = item; }
+    T* erase(T* it) {
+        std::copy(it + 1, end(), it);
+        count--;
+        return it;
+    }
+};
+
+struct GridPoint {
+    int x, y;
+};
+
+struct GameSnapshot {
+    GameState screen = INTRO;
+    int level = 1;
+    int score = 0;
+    int totalScore = 0;
+    int initialCheeseCount = 0;
+    int playerX = PLAYER_START_X, playerY = PLAYER_START_Y;
+    int catX = CAT_START_X, catY = CAT_START_Y;
+    Direction playerHeading = DIR_RIGHT; // Last direction the player moved in.
+    FixedList<GridPoint, NUM_CHEESE_TO_PLACE> cheese;
+    FixedList<Powerup, NUM_POWERUPS_PER_LEVEL> powerups;
+    FixedList<Ambusher, MAX_AMBUSHERS> ambushers;
+    bool catSlowed = false;
+    int catSlowTimer = 0;
+    int catDelay = INITIAL_CAT_DELAY_MS;
+    int normalCatDelay = 0;
+    int catCountdownMs = 0;             // Until the cat's next move, for fixed-step drivers (the window uses a GLUT timer).
+    uint32_t randomState = 0x2545F491u; // Game RNG, so restored games replay identically.
+    uint64_t hash = 0;                  // Zobrist hash of the state, updated incrementally.
+};
+static_assert(std::is_trivially_copyable<GameSnapshot>::value, "game state must be memcpy-able");
+
+GameSnapshot liveGame;
+GameState& currentGameState = liveGame.screen;
+int& currentLevel = liveGame.level;
+int& score = liveGame.score;
+int& totalScore = liveGame.totalScore;
+int& initialCheeseCount = liveGame.initialCheeseCount;
+int& playerX = liveGame.playerX;
+int& playerY = liveGame.playerY;
+int& catX = liveGame.catX;
+int& catY = liveGame.catY;
+Direction& playerHeading = liveGame.playerHeading;
+FixedList<GridPoint, NUM_CHEESE_TO_PLACE>& cheeseLocations = liveGame.cheese;
+FixedList<Powerup, NUM_POWERUPS_PER_LEVEL>& powerupLocations = liveGame.powerups;
+FixedList<Ambusher, MAX_AMBUSHERS>& ambushers = liveGame.ambushers;
+bool& isCatSlowed = liveGame.catSlowed;
+int& catSlowDurationTimer = liveGame.catSlowTimer;
+int& currentCatDelay = liveGame.catDelay;
+int& normalCatDelayBeforeSlowdown = liveGame.normalCatDelay;
+uint64_t& gameStateHash = liveGame.hash;
+
+/**
+ * @brief Draws the next gameplay random number (xorshift32 over the state block).
+ */
+uint32_t gameRandom() {
+    uint32_t x = liveGame.randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    liveGame.randomState = x;
+    return x;
+}
+
+// Everything that changes the game state arrives as one of these events, so a session
+// can be recorded and re-simulated exactly (see the Replays section).
+enum ReplayEventType : uint8_t { REPLAY_NEW_GAME, REPLAY_START_LEVEL, REPLAY_PLAYER_MOVE, REPLAY_CAT_MOVE, REPLAY_SLOW_TIMER, REPLAY_PAUSE, REPLAY_KEYFRAME };
 
 // Timer and state management variables
 int lastTickTime = 0;
@@ -107,25 +284,69 @@ const float CHEESE_SCALE_FACTOR = 0.7f;
 
 // --- Function Declarations ---
 void initMaze(int level);
+void copyLevelLayout(int level, int tiles[ROWS][COLS], std::vector<Portal>& portals);
 void initLevelData();
 void resetGame();
+void initZobristKeys();
+uint64_t computeGameStateHash();
+int slowdownBucket();
 void nextLevel();
-void processPlayerMove(int nextX, int nextY);
+int catDelayForProgress(const CatSpeedCurve& curve, float progress);
+const CatSpeedCurve& currentSpeedCurve();
+bool loadDifficultyFile(const std::string& path);
+void compileMazeGraph(MazeGraph& graph, const int* tiles, int width, int height, const std::vector<Portal>& portals);
+void patchMazeGraph(MazeGraph& graph, const int* tiles, const std::vector<Portal>& portals, std::vector<int>& cells);
+uint64_t mazeGraphHash(const MazeGraph& graph);
+void generateMaze(std::vector<int>& tiles, int width, int height, unsigned seed, double loopFraction);
+void processPlayerMove(Direction dir);
 void drawFilledCircle(float cx, float cy, float radius, float r, float g, float b);
 void drawConnectingRect(float x1, float y1, float x2, float y2, float radius, float r, float g, float b);
-void drawFilledelipse(GLfloat x, GLfloat y, GLfloat radiusX, GLfloat radiusY);
+void drawFilledelipse(float x, float y, float radiusX, float radiusY);
 void drawCustomCat(int gridX, int gridY, float cellSize);
 void drawCustomMouse(int gridX, int gridY, float cellSize);
 void drawCustomCheese(float drawX, float drawY, float drawSize);
 void drawPowerup(float drawX, float drawY, float size, float sparklePhase);
 void display();
 void moveCat();
+int catNextStep();
+uint8_t catStepDirection(int step);
+void moveCatTo(int step);
+bool bfsNextStep(int fromX, int fromY, int toX, int toY, int& stepX, int& stepY);
+void buildLevelPathfinding();
+void discardPredictiveSearch();
+void setTile(int x, int y, int tile);
+void loadLevelTablebase(int level);
+void updateChaserField();
+void updateSafeRoute();
+void snapshotGame(GameSnapshot& out);
+void restoreGame(const GameSnapshot& in);
+void loadLevelMaze(int level);
+void startLevel(int level);
+void advanceLevel();
+bool applyPlayerMove(Direction dir);
+void advanceSlowdownTimer(int deltaTime);
+void advanceGameClock(int elapsedMs);
+void recordReplayEvent(uint8_t type, uint8_t arg = 0, uint16_t value = 0);
+void replayViewerKeyboard(unsigned char key, int x, int y);
+void replayViewerSpecialKeyboard(int key, int x, int y);
+void drawReplayViewerBar();
+void networkClientKeyboard(unsigned char key, int x, int y);
+void networkClientSpecialKeyboard(int key, int x, int y);
+void versusKeyboard(unsigned char key, int x, int y);
+void versusSpecialKeyboard(int key, int x, int y);
+void placeItemsOptimized();
 void catTimer(int value);
 void keyboard(unsigned char key, int x, int y);
 void specialKeyboard(int key, int x, int y);
 void initOpenGL();
 void idle();
 void reshape(int w, int h);
+int runBenchmarks(int argc, char** argv);
+void benchStateDeltas(int events, std::mt19937& rng);
+void benchRollback(int ticks, std::mt19937& rng);
+int runTablebaseSolver(int argc, char** argv);
+int runDifficultyTuner(int argc, char** argv);
+int runReplayAnalytics(int argc, char** argv);
 int getTextWidth(const std::string& text, void* font);
 void renderTextAt(float x, float y, const std::string& text, void* font, float r, float g, float b);
 void renderCenteredText(float cx, float y, const std::string& text, void* font, float r, float g, float b);
@@ -136,10 +357,9 @@ void renderCenteredText(float cx, float y, const std::string& text, void* font,
 // -----------------------------------------------------------------------------
 
 /**
- * @brief Selects and loads a maze layout based on the current level.
- * @param level The level number to load the maze for.
+ * @brief Copies a level's stock layout and portals without loading it.
  */
-void initMaze(int level) {
+void copyLevelLayout(int level, int tiles[ROWS][COLS], std::vector<Portal>& portals) {
     int layout1[ROWS][COLS] = {
         {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
         {1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,1},
@@ -216,17 +436,191 @@ void initMaze(int level) {
         {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1}
     };
 
+    // Portals for each layout. All three share the classic horizontal tunnel on row 11.
+    const std::vector<Portal> portals1 = { {0, 11, DIR_LEFT, COLS - 1, 11} };
+    const std::vector<Portal> portals2 = { {0, 11, DIR_LEFT, COLS - 1, 11} };
+    const std::vector<Portal> portals3 = { {0, 11, DIR_LEFT, COLS - 1, 11} };
+
     int (*selectedLayout)[COLS];
     switch (level) {
-        case 2: selectedLayout = layout2; break;
-        case 3: selectedLayout = layout3; break;
-        default: selectedLayout = layout1;
+        case 2: selectedLayout = layout2; portals = portals2; break;
+        case 3: selectedLayout = layout3; portals = portals3; break;
+        default: selectedLayout = layout1; portals = portals1;
     }
     for (int y = 0; y < ROWS; ++y) {
         for (int x = 0; x < COLS; ++x) {
-            maze[y][x] = selectedLayout[y][x];
+            tiles[y][x] = selectedLayout[y][x];
+        }
+    }
+}
+
+/**
+ * @brief Selects and loads a maze layout based on the current level.
+ * @param level The level number to load the maze for.
+ */
+void initMaze(int level) {
+    discardPredictiveSearch(); // The planner reads the graph that is about to be replaced.
+    copyLevelLayout(level, maze, levelPortals);
+    compileMazeGraph(mazeGraph, &maze[0][0], COLS, ROWS, levelPortals);
+    loadedMazeLevel = level;
+    buildLevelPathfinding();
+    if (catPathfinder == PATHFINDER_TABLEBASE) loadLevelTablebase(level);
+}
+
+/**
+ * @brief Compiles a tile grid and its portals into CSR adjacency.
+ * Only TILE_PATH cells are walkable. Portals override the plain step in their direction,
+ * and the cell they displace loses its step back, so adjacency stays symmetric and
+ * movement and search never need bounds or wrap-around checks.
+ * @param graph The graph to (re)build.
+ * @param tiles Row-major tile values, width * height entries.
+ * @param width The grid width in cells.
+ * @param height The grid height in cells.
+ * @param portals Two-way portals; pairs touching a non-path cell are ignored.
+ */
+void compileMazeGraph(MazeGraph& graph, const int* tiles, int width, int height, const std::vector<Portal>& portals) {
+    int cellCount = width * height;
+    graph.width = width;
+    graph.height = height;
+    graph.walkable.assign(cellCount, false);
+    graph.moves.resize(cellCount * 4);
+    for (int cell = 0; cell < cellCount; ++cell) graph.walkable[cell] = (tiles[cell] == TILE_PATH);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int cell = y * width + x;
+            for (int dir = 0; dir < 4; ++dir) {
+                int nx = x + DIR_DX[dir];
+                int ny = y + DIR_DY[dir];
+                bool open = graph.walkable[cell] && nx >= 0 && nx < width && ny >= 0 && ny < height && graph.walkable[ny * width + nx];
+                graph.moves[cell * 4 + dir] = open ? ny * width + nx : cell;
+            }
+        }
+    }
+    for (const auto& p : portals) {
+        int from = p.y * width + p.x;
+        int to = p.toY * width + p.toX;
+        if (!graph.walkable[from] || !graph.walkable[to]) continue;
+        // A portal replaces any plain step it overrides, so that neighbor loses its way back too.
+        int displacedFrom = graph.moves[from * 4 + p.dir];
+        if (displacedFrom != from && graph.moves[displacedFrom * 4 + DIR_OPPOSITE[p.dir]] == from) graph.moves[displacedFrom * 4 + DIR_OPPOSITE[p.dir]] = displacedFrom;
+        int displacedTo = graph.moves[to * 4 + DIR_OPPOSITE[p.dir]];
+        if (displacedTo != to && graph.moves[displacedTo * 4 + p.dir] == to) graph.moves[displacedTo * 4 + p.dir] = displacedTo;
+        graph.moves[from * 4 + p.dir] = to;
+        graph.moves[to * 4 + DIR_OPPOSITE[p.dir]] = from;
+    }
+
+    // Neighbor lists are the distinct move destinations, in direction order.
+    graph.offsets.assign(cellCount + 1, 0);
+    graph.targets.clear();
+    for (int cell = 0; cell < cellCount; ++cell) {
+        graph.offsets[cell] = graph.targets.size();
+        for (int dir = 0; dir < 4; ++dir) {
+            int next = graph.moves[cell * 4 + dir];
+            if (next == cell) continue;
+            bool duplicate = false;
+            for (int i = graph.offsets[cell]; i < (int)graph.targets.size(); ++i) duplicate = duplicate || graph.targets[i] == next;
+            if (!duplicate) graph.targets.push_back(next);
+        }
+    }
+    graph.offsets[cellCount] = graph.targets.size();
+}
+
+/**
+ * @brief Recompiles the adjacency of a few cells after their tiles changed, with the same
+ * rules as compileMazeGraph(). Only the affected rows are rebuilt; when a row changes
+ * size, the rest of the targets array shifts once to make room.
+ * @param cells The changed cells. Receives, sorted, every cell whose row was rebuilt:
+ * the changed cells, their grid neighbors, and both ends of any portal touching them.
+ */
+void patchMazeGraph(MazeGraph& graph, const int* tiles, const std::vector<Portal>& portals, std::vector<int>& cells) {
+    int width = graph.width, height = graph.height;
+    std::vector<int> affected;
+    auto addWithNeighbors = [&](int cell) {
+        affected.push_back(cell);
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = cell % width + DIR_DX[dir], ny = cell / width + DIR_DY[dir];
+            if (nx >= 0 && nx < width && ny >= 0 && ny < height) affected.push_back(ny * width + nx);
+        }
+    };
+    for (int cell : cells) addWithNeighbors(cell);
+    // A portal rewrites both its ends and the neighbors they displace, so pull in every
+    // portal that touches an affected cell until the set is closed.
+    std::vector<bool> portalApplied(portals.size(), false);
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (size_t i = 0; i < portals.size(); ++i) {
+            if (portalApplied[i]) continue;
+            int from = portals[i].y * width + portals[i].x, to = portals[i].toY * width + portals[i].toX;
+            if (std::find(affected.begin(), affected.end(), from) == affected.end() &&
+                std::find(affected.begin(), affected.end(), to) == affected.end()) continue;
+            addWithNeighbors(from);
+            addWithNeighbors(to);
+            portalApplied[i] = grew = true;
+        }
+    }
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for (int cell : affected) graph.walkable[cell] = (tiles[cell] == TILE_PATH);
+    for (int cell : affected) {
+        int x = cell % width, y = cell / width;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = x + DIR_DX[dir], ny = y + DIR_DY[dir];
+            bool open = graph.walkable[cell] && nx >= 0 && nx < width && ny >= 0 && ny < height && graph.walkable[ny * width + nx];
+            graph.moves[cell * 4 + dir] = open ? ny * width + nx : cell;
+        }
+    }
+    for (size_t i = 0; i < portals.size(); ++i) {
+        if (!portalApplied[i]) continue;
+        const Portal& p = portals[i];
+        int from = p.y * width + p.x, to = p.toY * width + p.toX;
+        if (!graph.walkable[from] || !graph.walkable[to]) continue;
+        int displacedFrom = graph.moves[from * 4 + p.dir];
+        if (displacedFrom != from && graph.moves[displacedFrom * 4 + DIR_OPPOSITE[p.dir]] == from) graph.moves[displacedFrom * 4 + DIR_OPPOSITE[p.dir]] = displacedFrom;
+        int displacedTo = graph.moves[to * 4 + DIR_OPPOSITE[p.dir]];
+        if (displacedTo != to && graph.moves[displacedTo * 4 + p.dir] == to) graph.moves[displacedTo * 4 + p.dir] = displacedTo;
+        graph.moves[from * 4 + p.dir] = to;
+        graph.moves[to * 4 + DIR_OPPOSITE[p.dir]] = from;
+    }
+
+    // New rows for the affected cells, then splice them over the old ones.
+    std::vector<int> rows, rowStart, oldSize;
+    int sizeDelta = 0;
+    for (int cell : affected) {
+        rowStart.push_back(rows.size());
+        for (int dir = 0; dir < 4; ++dir) {
+            int next = graph.moves[cell * 4 + dir];
+            if (next != cell && std::find(rows.begin() + rowStart.back(), rows.end(), next) == rows.end()) rows.push_back(next);
+        }
+        oldSize.push_back(graph.offsets[cell + 1] - graph.offsets[cell]);
+        sizeDelta += (int)rows.size() - rowStart.back() - oldSize.back();
+    }
+    rowStart.push_back(rows.size());
+    // Without a net size change, nothing past the last affected row moves.
+    int cellCount = width * height;
+    int spliceEnd = (sizeDelta == 0) ? graph.offsets[affected.back() + 1] : graph.targets.size();
+    std::vector<int> spliced;
+    int cursor = graph.offsets[affected.front()];
+    for (size_t i = 0; i < affected.size(); ++i) {
+        spliced.insert(spliced.end(), graph.targets.begin() + cursor, graph.targets.begin() + graph.offsets[affected[i]]);
+        spliced.insert(spliced.end(), rows.begin() + rowStart[i], rows.begin() + rowStart[i + 1]);
+        cursor = graph.offsets[affected[i] + 1];
+    }
+    spliced.insert(spliced.end(), graph.targets.begin() + cursor, graph.targets.begin() + spliceEnd);
+    graph.targets.resize(graph.targets.size() + sizeDelta);
+    std::copy(spliced.begin(), spliced.end(), graph.targets.begin() + graph.offsets[affected.front()]);
+    int lastCell = (sizeDelta == 0) ? affected.back() : cellCount - 1;
+    int shift = 0;
+    size_t next = 0;
+    for (int cell = affected.front(); cell <= lastCell; ++cell) {
+        if (next < affected.size() && affected[next] == cell) {
+            shift += rowStart[next + 1] - rowStart[next] - oldSize[next];
+            next++;
         }
+        graph.offsets[cell + 1] += shift;
     }
+    cells.swap(affected);
 }
 
 /**
@@ -234,7 +628,8 @@ void initMaze(int level) {
  */
 void initLevelData() {
     score = 0;
-    currentCatDelay = INITIAL_CAT_DELAY_MS;
+    currentCatDelay = currentSpeedCurve().initialDelayMs;
+    liveGame.catCountdownMs = 0; // Like catTimer(), the cat moves as soon as the level starts.
     cheeseLocations.clear();
     powerupLocations.clear();
     const int initialPlayerX = PLAYER_START_X;
@@ -245,14 +640,19 @@ void initLevelData() {
     int placedPowerups = 0;
     int attempts = 0;
     const int maxAttempts = ROWS * COLS * 10;
+    if (optimizeItemPlacement) {
+        placeItemsOptimized(); // Anything it could not place is filled in randomly below.
+        placedCheese = cheeseLocations.size();
+        placedPowerups = powerupLocations.size();
+    }
     while (placedCheese < NUM_CHEESE_TO_PLACE && attempts < maxAttempts) {
         attempts++;
-        int rx = rand() % COLS;
-        int ry = rand() % ROWS;
+        int rx = gameRandom() % COLS;
+        int ry = gameRandom() % ROWS;
         if (maze[ry][rx] == TILE_PATH && !(rx == initialPlayerX && ry == initialPlayerY) && !(rx == initialCatX && ry == initialCatY)) {
             bool alreadyExists = false;
             for (const auto& loc : cheeseLocations) {
-                if (loc.first == rx && loc.second == ry) {
+                if (loc.x == rx && loc.y == ry) {
                     alreadyExists = true;
                     break;
                 }
@@ -266,12 +666,12 @@ void initLevelData() {
     attempts = 0;
     while (placedPowerups < NUM_POWERUPS_PER_LEVEL && attempts < maxAttempts) {
          attempts++;
-         int rx = rand() % COLS;
-         int ry = rand() % ROWS;
+         int rx = gameRandom() % COLS;
+         int ry = gameRandom() % ROWS;
          if (maze[ry][rx] == TILE_PATH && !(rx == initialPlayerX && ry == initialPlayerY) && !(rx == initialCatX && ry == initialCatY)) {
             bool cheeseExists = false;
             for (const auto& loc : cheeseLocations) {
-                if (loc.first == rx && loc.second == ry) {
+                if (loc.x == rx && loc.y == ry) {
                     cheeseExists = true;
                     break;
                 }
@@ -290,17 +690,61 @@ void initLevelData() {
          }
     }
     initialCheeseCount = cheeseLocations.size();
-    if (placedCheese < NUM_CHEESE_TO_PLACE) std::cout << "Warning: Could only place " << placedCheese << " cheese.\n";
-    if (placedPowerups < NUM_POWERUPS_PER_LEVEL) std::cout << "Warning: Could only place " << placedPowerups << " powerups.\n";
-    if (initialCheeseCount > 0 || placedPowerups > 0) std::cout << "Level " << currentLevel << " started. Collect " << initialCheeseCount << " cheese! Cat Delay: " << currentCatDelay << "ms\n";
-    else std::cout << "Warning: No items placed for level " << currentLevel << ".\n";
+    if (engineLog) {
+        if (placedCheese < NUM_CHEESE_TO_PLACE) std::cout << "Warning: Could only place " << placedCheese << " cheese.\n";
+        if (placedPowerups < NUM_POWERUPS_PER_LEVEL) std::cout << "Warning: Could only place " << placedPowerups << " powerups.\n";
+        if (initialCheeseCount > 0 || placedPowerups > 0) std::cout << "Level " << currentLevel << " started. Collect " << initialCheeseCount << " cheese! Cat Delay: " << currentCatDelay << "ms\n";
+        else std::cout << "Warning: No items placed for level " << currentLevel << ".\n";
+    }
     playerX = PLAYER_START_X;
     playerY = PLAYER_START_Y;
     catX = CAT_START_X;
     catY = CAT_START_Y;
+    playerHeading = DIR_RIGHT;
+    ambushers.clear();
+    for (ChaserPersonality personality : ambusherPersonalities) ambushers.push_back({CAT_START_X, CAT_START_Y, personality});
     isCatSlowed = false;
     catSlowDurationTimer = 0;
     normalCatDelayBeforeSlowdown = currentCatDelay;
+    gameStateHash = computeGameStateHash();
+    updateChaserField();
+    updateSafeRoute();
+}
+
+/**
+ * @brief Generates a random maze of any size for benchmarks and stress tests.
+ * A perfect maze is carved on odd cells with an iterative recursive backtracker,
+ * then a fraction of the remaining inner walls is knocked out to create loops.
+ * @param tiles Receives width * height row-major tile values.
+ * @param loopFraction Probability of removing each remaining removable wall.
+ */
+void generateMaze(std::vector<int>& tiles, int width, int height, unsigned seed, double loopFraction) {
+    std::mt19937 rng(seed);
+    tiles.assign(width * height, TILE_WALL);
+    std::vector<int> stack = {1 * width + 1};
+    tiles[width + 1] = TILE_PATH;
+    while (!stack.empty()) {
+        int cell = stack.back();
+        int x = cell % width, y = cell / width;
+        int options[4], count = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = x + 2 * DIR_DX[dir], ny = y + 2 * DIR_DY[dir];
+            if (nx > 0 && nx < width - 1 && ny > 0 && ny < height - 1 && tiles[ny * width + nx] == TILE_WALL) options[count++] = dir;
+        }
+        if (count == 0) { stack.pop_back(); continue; }
+        int dir = options[rng() % count];
+        tiles[(y + DIR_DY[dir]) * width + (x + DIR_DX[dir])] = TILE_PATH;
+        tiles[(y + 2 * DIR_DY[dir]) * width + (x + 2 * DIR_DX[dir])] = TILE_PATH;
+        stack.push_back((y + 2 * DIR_DY[dir]) * width + (x + 2 * DIR_DX[dir]));
+    }
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    for (int y = 1; y < height - 1; ++y) {
+        for (int x = 1; x < width - 1; ++x) {
+            // Walls between two horizontally or vertically adjacent carved cells.
+            bool between = (x % 2 == 0 && y % 2 == 1) || (x % 2 == 1 && y % 2 == 0);
+            if (between && tiles[y * width + x] == TILE_WALL && chance(rng) < loopFraction) tiles[y * width + x] = TILE_PATH;
+        }
+    }
 }
 
 
@@ -308,6 +752,155 @@ void initLevelData() {
 // GAME STATE AND FLOW CONTROL
 // -----------------------------------------------------------------------------
 
+// --- Zobrist Hashing ---
+// A 64-bit hash of the full game state, kept up to date in O(1) by XOR-ing keys in and
+// out as pieces move and items are collected. Keys come from a fixed seed, so two
+// instances playing the same game agree on every hash (useful for desync detection).
+const int SLOWDOWN_BUCKET_MS = 1000;
+const int SLOWDOWN_BUCKETS = CAT_SLOW_DURATION_MS / SLOWDOWN_BUCKET_MS + 1;
+uint64_t zobristPlayer[ROWS * COLS];
+uint64_t zobristCat[ROWS * COLS];
+uint64_t zobristAmbusher[MAX_AMBUSHERS][ROWS * COLS];
+uint64_t zobristCheese[ROWS * COLS];
+uint64_t zobristPowerup[ROWS * COLS];
+uint64_t zobristSlowed;
+uint64_t zobristSlowBucket[SLOWDOWN_BUCKETS];
+uint64_t zobristLevel[MAX_LEVELS + 1];
+uint64_t zobristChanceNode;       // Search-only: marks positions with the player to move.
+uint64_t zobristSearchDepth[64];  // Search-only: remaining lookahead depth.
+
+/**
+ * @brief Fills the key tables. Called once at startup.
+ */
+void initZobristKeys() {
+    std::mt19937_64 rng(0x43415421u);
+    for (int cell = 0; cell < ROWS * COLS; ++cell) {
+        zobristPlayer[cell] = rng();
+        zobristCat[cell] = rng();
+        zobristCheese[cell] = rng();
+        zobristPowerup[cell] = rng();
+    }
+    for (auto& keys : zobristAmbusher) for (auto& key : keys) key = rng();
+    zobristSlowed = rng();
+    for (auto& key : zobristSlowBucket) key = rng();
+    for (auto& key : zobristLevel) key = rng();
+    zobristChanceNode = rng();
+    for (auto& key : zobristSearchDepth) key = rng();
+}
+
+/**
+ * @brief The slowdown timer, quantized so the hash only changes a few times per power-up.
+ */
+int slowdownBucket() {
+    if (!isCatSlowed) return 0;
+    return std::min(SLOWDOWN_BUCKETS - 1, std::max(0, (catSlowDurationTimer + SLOWDOWN_BUCKET_MS - 1) / SLOWDOWN_BUCKET_MS));
+}
+
+/**
+ * @brief Recomputes the hash from scratch; incremental updates must always agree with it.
+ */
+uint64_t computeGameStateHash() {
+    uint64_t hash = zobristLevel[std::min(currentLevel, MAX_LEVELS)];
+    hash ^= zobristPlayer[playerY * COLS + playerX];
+    hash ^= zobristCat[catY * COLS + catX];
+    for (int i = 0; i < ambushers.size(); ++i) hash ^= zobristAmbusher[i][ambushers[i].y * COLS + ambushers[i].x];
+    for (const auto& loc : cheeseLocations) hash ^= zobristCheese[loc.y * COLS + loc.x];
+    for (const auto& p : powerupLocations) hash ^= zobristPowerup[p.y * COLS + p.x];
+    if (isCatSlowed) hash ^= zobristSlowed;
+    hash ^= zobristSlowBucket[slowdownBucket()];
+    return hash;
+}
+
+// --- Lock-Free Transposition Table ---
+// Shared by all search threads without locks. Each slot stores (key ^ data, data) in two
+// relaxed atomics; a torn write from two racing threads fails the key check on probe and
+// simply reads as a miss.
+struct TranspositionEntry {
+    std::atomic<uint64_t> check{0};
+    std::atomic<uint64_t> data{0};
+};
+
+struct TranspositionTable {
+    std::vector<TranspositionEntry> entries;
+    uint64_t mask = 0;
+};
+
+/**
+ * @brief Allocates 2^sizeLog2 empty slots.
+ */
+void ttInit(TranspositionTable& tt, int sizeLog2) {
+    tt.entries = std::vector<TranspositionEntry>((size_t)1 << sizeLog2);
+    tt.mask = ((uint64_t)1 << sizeLog2) - 1;
+}
+
+void ttClear(TranspositionTable& tt) {
+    for (auto& e : tt.entries) {
+        e.check.store(0, std::memory_order_relaxed);
+        e.data.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Stores a search value (as a float) for a key, always replacing the slot.
+ */
+void ttStore(TranspositionTable& tt, uint64_t key, float value) {
+    if (tt.entries.empty()) return;
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t data = (uint64_t)bits | ((uint64_t)1 << 32); // Bit 32 marks the slot as used.
+    TranspositionEntry& e = tt.entries[key & tt.mask];
+    e.check.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+bool ttProbe(const TranspositionTable& tt, uint64_t key, float& value) {
+    if (tt.entries.empty()) return false;
+    const TranspositionEntry& e = tt.entries[key & tt.mask];
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    if (data == 0 || (e.check.load(std::memory_order_relaxed) ^ data) != key) return false;
+    uint32_t bits = (uint32_t)data;
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+// --- Cat Speed Curve ---
+/**
+ * @brief The cat delay once a fraction of the level's cheese has been collected.
+ */
+int catDelayForProgress(const CatSpeedCurve& curve, float progress) {
+    float eased = (curve.exponent == 0.5f) ? sqrt(progress) : pow(progress, curve.exponent);
+    int delay = curve.minDelayMs + (int)((curve.initialDelayMs - curve.minDelayMs) * (1.0f - eased));
+    return std::max(curve.minDelayMs, delay);
+}
+
+const CatSpeedCurve& currentSpeedCurve() {
+    return levelSpeedCurves[std::max(1, std::min(currentLevel, MAX_LEVELS))];
+}
+
+/**
+ * @brief Reads tuned per-level speed curves, one line per level:
+ * "level <n> initial_delay_ms <ms> min_delay_ms <ms> exponent <e>". Unlisted levels keep the defaults.
+ * @return True if the file was found.
+ */
+bool loadDifficultyFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream fields(line);
+        std::string levelKey, initialKey, minKey, exponentKey;
+        int level;
+        CatSpeedCurve curve;
+        if (!(fields >> levelKey >> level >> initialKey >> curve.initialDelayMs >> minKey >> curve.minDelayMs >> exponentKey >> curve.exponent)) continue;
+        if (level < 1 || level > MAX_LEVELS || curve.minDelayMs <= 0 || curve.initialDelayMs < curve.minDelayMs) continue;
+        levelSpeedCurves[level] = curve;
+        if (engineLog) std::cout << "Level " << level << " speed curve: " << curve.initialDelayMs << " -> " << curve.minDelayMs << " ms, exponent " << curve.exponent << "\n";
+    }
+    return true;
+}
+
+#ifndef CHASE_LIBRARY
 /**
  * @brief Resets the game to its initial state (Level 1, score 0).
  */
@@ -315,36 +908,54 @@ void resetGame() {
     std::cout << "--- Game Reset! ---\n";
     resetIdentifier++;
     timerActive = false;
-    currentLevel = 1;
+    recordReplayEvent(REPLAY_NEW_GAME);
     totalScore = 0;
-    initMaze(currentLevel);
-    initLevelData();
-    currentGameState = PLAYING;
+    startLevel(1);
     timerActive = true;
     lastTickTime = glutGet(GLUT_ELAPSED_TIME);
     catTimer(resetIdentifier);
     glutPostRedisplay();
 }
+#endif // CHASE_LIBRARY
 
 /**
- * @brief Advances the game to the next level or triggers the win condition.
+ * @brief Loads a level and places its items, leaving the game ready to play.
+ * Unlike resetGame() this touches no window or timer state, so headless code can use it.
  */
-void nextLevel() {
+void startLevel(int level) {
+    currentLevel = level;
+    loadLevelMaze(level);
+    initLevelData();
+    currentGameState = PLAYING;
+}
+
+/**
+ * @brief Banks the level score and advances to the next level or the win condition.
+ */
+void advanceLevel() {
      totalScore += score;
      score = 0;
      currentLevel++;
-     timerActive = false;
      if (currentLevel > MAX_LEVELS) {
          currentGameState = GAME_WON_FINAL;
-         std::cout << "************************************\n*   You beat all levels! YOU WIN!  *\n*      Final Score: " << totalScore <<"           *\n************************************\n";
+         if (engineLog) std::cout << "************************************\n*   You beat all levels! YOU WIN!  *\n*      Final Score: " << totalScore <<"           *\n************************************\n";
      } else {
-         std::cout << "************************************\n*      Level Complete!             *\n*      Proceeding to Level " << currentLevel << "       *\n************************************\n";
+         if (engineLog) std::cout << "************************************\n*      Level Complete!             *\n*      Proceeding to Level " << currentLevel << "       *\n************************************\n";
          currentGameState = GAME_WON_LEVEL;
+     }
+}
+
+#ifndef CHASE_LIBRARY
+/**
+ * @brief Stops the cat after advanceLevel() and schedules the next level, if there is one.
+ */
+void nextLevel() {
+     timerActive = false;
+     if (currentGameState == GAME_WON_LEVEL) {
          glutTimerFunc(2000, [](int v_current_level_for_lambda){
               resetIdentifier++;
-              initMaze(v_current_level_for_lambda);
-              initLevelData();
-              currentGameState = PLAYING;
+              recordReplayEvent(REPLAY_START_LEVEL, v_current_level_for_lambda);
+              startLevel(v_current_level_for_lambda);
               timerActive = true;
               lastTickTime = glutGet(GLUT_ELAPSED_TIME);
               catTimer(resetIdentifier);
@@ -353,12 +964,14 @@ void nextLevel() {
      }
      glutPostRedisplay();
 }
+#endif // CHASE_LIBRARY
 
 
 // -----------------------------------------------------------------------------
 // DRAWING AND RENDERING
 // -----------------------------------------------------------------------------
 
+#ifndef CHASE_LIBRARY
 // --- Primitive Drawing Functions ---
 void drawFilledCircle(float cx, float cy, float radius, float r, float g, float b) {
     int num_segments = 80; glColor3f(r, g, b); glBegin(GL_TRIANGLE_FAN);
@@ -490,15 +1103,13 @@ void display() {
         for (int y = 0; y < ROWS; ++y) { for (int x = 0; x < COLS; ++x) { if (maze[y][x] == TILE_WALL) {
             float cX = (x + 0.5f) * CELL_SIZE, cY = (y + 0.5f) * CELL_SIZE;
             drawFilledCircle(cX, cY, OUTER_WALL_RADIUS, OUTLINE_COLOR_R, OUTLINE_COLOR_G, OUTLINE_COLOR_B);
-            if (x + 1 < COLS && maze[y][x + 1] == TILE_WALL) { if (!(y == TUNNEL_ROW_INDEX && x == COLS - 1 && maze[y][0] == TILE_PATH)) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, OUTER_WALL_RADIUS, OUTLINE_COLOR_R, OUTLINE_COLOR_G, OUTLINE_COLOR_B); }
-            if (y == TUNNEL_ROW_INDEX && x == COLS - 1 && maze[y][0] == TILE_WALL) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, OUTER_WALL_RADIUS, OUTLINE_COLOR_R, OUTLINE_COLOR_G, OUTLINE_COLOR_B);
+            if (x + 1 < COLS && maze[y][x + 1] == TILE_WALL) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, OUTER_WALL_RADIUS, OUTLINE_COLOR_R, OUTLINE_COLOR_G, OUTLINE_COLOR_B);
             if (y + 1 < ROWS && maze[y + 1][x] == TILE_WALL) drawConnectingRect(cX, cY, cX, cY + CELL_SIZE, OUTER_WALL_RADIUS, OUTLINE_COLOR_R, OUTLINE_COLOR_G, OUTLINE_COLOR_B);
         } } }
         for (int y = 0; y < ROWS; ++y) { for (int x = 0; x < COLS; ++x) { if (maze[y][x] == TILE_WALL) {
             float cX = (x + 0.5f) * CELL_SIZE, cY = (y + 0.5f) * CELL_SIZE;
             drawFilledCircle(cX, cY, INNER_WALL_RADIUS, FILL_COLOR_R, FILL_COLOR_G, FILL_COLOR_B);
-            if (x + 1 < COLS && maze[y][x + 1] == TILE_WALL) { if (!(y == TUNNEL_ROW_INDEX && x == COLS - 1 && maze[y][0] == TILE_PATH)) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, INNER_WALL_RADIUS, FILL_COLOR_R, FILL_COLOR_G, FILL_COLOR_B); }
-            if (y == TUNNEL_ROW_INDEX && x == COLS - 1 && maze[y][0] == TILE_WALL) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, INNER_WALL_RADIUS, FILL_COLOR_R, FILL_COLOR_G, FILL_COLOR_B);
+            if (x + 1 < COLS && maze[y][x + 1] == TILE_WALL) drawConnectingRect(cX, cY, cX + CELL_SIZE, cY, INNER_WALL_RADIUS, FILL_COLOR_R, FILL_COLOR_G, FILL_COLOR_B);
             if (y + 1 < ROWS && maze[y + 1][x] == TILE_WALL) drawConnectingRect(cX, cY, cX, cY + CELL_SIZE, INNER_WALL_RADIUS, FILL_COLOR_R, FILL_COLOR_G, FILL_COLOR_B);
         } } }
     }
@@ -525,10 +1136,14 @@ void display() {
 
     // --- 3. Draw Game Objects (Characters and Items) ---
     if (currentGameState == PLAYING || currentGameState == PAUSED) {
-        for (const auto& loc : cheeseLocations) { float cDX = (loc.first + 0.5f) * CELL_SIZE; float cDY = (loc.second + 0.5f) * CELL_SIZE; drawCustomCheese(cDX, cDY, CELL_SIZE * CHEESE_SCALE_FACTOR); }
+        if (showSafeRouteHint) {
+            for (int cell : safeRoute) drawFilledCircle((cell % COLS + 0.5f) * CELL_SIZE, (cell / COLS + 0.5f) * CELL_SIZE, CELL_SIZE * 0.12f, 0.3f, 1.0f, 0.4f);
+        }
+        for (const auto& loc : cheeseLocations) { float cDX = (loc.x + 0.5f) * CELL_SIZE; float cDY = (loc.y + 0.5f) * CELL_SIZE; drawCustomCheese(cDX, cDY, CELL_SIZE * CHEESE_SCALE_FACTOR); }
         for (auto& p : powerupLocations) { float pDX = (p.x + 0.5f) * CELL_SIZE; float pDY = (p.y + 0.5f) * CELL_SIZE; drawPowerup(pDX, pDY, CELL_SIZE * CHEESE_SCALE_FACTOR, p.sparklePhase); }
         drawCustomMouse(playerX, playerY, CELL_SIZE);
         drawCustomCat(catX, catY, CELL_SIZE);
+        for (const auto& a : ambushers) drawCustomCat(a.x, a.y, CELL_SIZE);
     }
 
     // --- 4. Draw Full-Screen Overlays (Menus) ---
@@ -565,6 +1180,7 @@ void display() {
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "WASD or Arrow Keys to Move", GLUT_BITMAP_HELVETICA_12, 1.0f, 1.0f, 1.0f); y_pos += 25;
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "P to Pause / Resume", GLUT_BITMAP_HELVETICA_12, 1.0f, 1.0f, 1.0f); y_pos += 25;
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "R to Reset Game", GLUT_BITMAP_HELVETICA_12, 1.0f, 1.0f, 1.0f); y_pos += 25;
+        renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "H to Show / Hide the Safest Route", GLUT_BITMAP_HELVETICA_12, 1.0f, 1.0f, 1.0f); y_pos += 25;
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "ESC to Quit", GLUT_BITMAP_HELVETICA_12, 1.0f, 1.0f, 1.0f); y_pos += 35;
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "Collect all the cheese to advance, Avoid the cat it gets faster !", GLUT_BITMAP_HELVETICA_12, 0.8f, 0.8f, 0.8f); y_pos += 20;
         renderCenteredText(WINDOW_WIDTH / 2.0f, y_pos, "Blue items will temporarily slow the cat down.", GLUT_BITMAP_HELVETICA_12, 0.8f, 0.8f, 0.8f);
@@ -573,9 +1189,11 @@ void display() {
         renderCenteredText(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 50, "Game by Mohamed Naeem", GLUT_BITMAP_9_BY_15, 0.6f, 0.6f, 0.8f);
         renderCenteredText(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 35, "GitHub: Naeemx7", GLUT_BITMAP_9_BY_15, 0.6f, 0.6f, 0.8f);
     }
+    if (viewingReplay) drawReplayViewerBar();
 
     glutSwapBuffers();
 }
+#endif // CHASE_LIBRARY
 
 
 // -----------------------------------------------------------------------------
@@ -583,369 +1201,6466 @@ void display() {
 // -----------------------------------------------------------------------------
 
 /**
- * @brief Uses Breadth-First Search (BFS) to find the shortest path from the cat to the player.
- * It then moves the cat one step along this path.
+ * @brief Cell-level Breadth-First Search (BFS) from one cell to another.
+ * This is the exact reference search; it expands every cell closer than the target.
+ * @param stepX Receives the X coordinate of the first step, or -1 if already at the target.
+ * @param stepY Receives the Y coordinate of the first step, or -1 if already at the target.
+ * @return True if the target is reachable.
  */
-void moveCat() {
-    std::queue<std::pair<int, int>> q;
-    int parent[ROWS][COLS][2];
-    bool visited[ROWS][COLS] = {false};
-    for (int y = 0; y < ROWS; ++y) {
-        for (int x = 0; x < COLS; ++x) {
-            parent[y][x][0] = parent[y][x][1] = -1;
+bool bfsNextStep(int fromX, int fromY, int toX, int toY, int& stepX, int& stepY) {
+    const int* offsets = mazeGraph.offsets.data();
+    const int* targets = mazeGraph.targets.data();
+    int queue[ROWS * COLS];
+    int parent[ROWS * COLS];
+    bool visited[ROWS * COLS] = {false};
+    int head = 0, tail = 0;
+    int fromCell = fromY * COLS + fromX;
+    int toCell = toY * COLS + toX;
+
+    queue[tail++] = fromCell;
+    visited[fromCell] = true;
+    parent[fromCell] = -1;
+    lastSearchNodesTouched = 0;
+    bool found = (fromCell == toCell);
+
+    // Standard BFS algorithm to find the target
+    while (head < tail && !found) {
+        int current = queue[head++];
+        lastSearchNodesTouched++;
+        for (int i = offsets[current]; i < offsets[current + 1]; ++i) {
+            int next = targets[i];
+            if (!visited[next]) {
+                visited[next] = true;
+                parent[next] = current;
+                queue[tail++] = next;
+                if (next == toCell) {
+                    found = true;
+                    break;
+                }
+            }
         }
     }
 
-    q.push({catX, catY});
-    visited[catY][catX] = true;
+    stepX = stepY = -1;
+    if (!found) return false;
 
-    int dx[] = {0, 0, -1, 1};
-    int dy[] = {-1, 1, 0, 0};
-    int targetX = -1, targetY = -1;
-    bool found = false;
-
-    // Standard BFS algorithm to find the player
-    while (!q.empty() && !found) {
-        std::pair<int, int> current = q.front();
-        q.pop();
-        int x_bfs = current.first;
-        int y_bfs = current.second;
+    // Backtrack from the target to find the first step
+    int cell = toCell;
+    while (cell != fromCell && parent[cell] != fromCell) cell = parent[cell];
+    if (cell != fromCell) {
+        stepX = cell % COLS;
+        stepY = cell / COLS;
+    }
+    return true;
+}
 
-        if (x_bfs == playerX && y_bfs == playerY) {
-            targetX = x_bfs;
-            targetY = y_bfs;
-            found = true;
-            break;
-        }
+// --- Junction Graph ---
+// Corridor cells (exactly two open neighbors) are collapsed into weighted edges
+// between junctions and dead ends, so chasers search far fewer nodes.
+struct JunctionEdge {
+    int a, b;      // Endpoint node ids.
+    int length;    // Number of steps from a to b.
+    int firstCell; // Index into JunctionGraph::edgeCells of the corridor cell next to a.
+};
+struct JunctionGraph {
+    const MazeGraph* graph = nullptr;
+    std::vector<int> nodeCells;                        // Node id -> cell index.
+    std::vector<JunctionEdge> edges;
+    std::vector<int> edgeCells;                        // Corridor cells of every edge, ordered from a to b.
+    std::vector<std::vector<std::pair<int, int>>> adj; // Node id -> (edge id, 0 if leaving via a else 1).
+    std::vector<int> nodeAt;   // Cell index -> node id, or -1.
+    std::vector<int> edgeAt;   // Cell index -> edge id of a corridor cell, or -1.
+    std::vector<int> offsetAt; // Cell index -> steps from the edge's endpoint a.
+    int maxEdgeLength = 1;
+    int garbageCells = 0;      // Entries of edgeCells left behind by patched-out edges.
+    // Dijkstra scratch space, reused between searches to avoid per-tick allocation.
+    std::vector<int> dist;
+    std::vector<int> stamp;
+    std::vector<bool> settled;
+    std::vector<std::vector<int>> buckets;
+    int searchStamp = 0;
+};
+JunctionGraph levelJunctions; // Built for mazeGraph at every level load.
 
-        for (int i = 0; i < 4 && !found; ++i) {
-            int nx = x_bfs + dx[i];
-            int ny = y_bfs + dy[i];
+/**
+ * @brief Follows a corridor from a node through one of its neighbors and records the edge.
+ * @param startNode The node the walk leaves from.
+ * @param firstCell The first cell after the node.
+ */
+void walkJunctionEdge(JunctionGraph& j, int startNode, int firstCell) {
+    const int* offsets = j.graph->offsets.data();
+    const int* targets = j.graph->targets.data();
+    int prev = j.nodeCells[startNode];
+    int cell = firstCell;
+    JunctionEdge edge;
+    edge.a = startNode;
+    edge.firstCell = j.edgeCells.size();
+    int edgeId = j.edges.size();
+    int length = 1;
+    while (j.nodeAt[cell] == -1) {
+        j.edgeAt[cell] = edgeId;
+        j.offsetAt[cell] = length;
+        j.edgeCells.push_back(cell);
+        // Corridor cells have exactly two neighbors: continue through the one we did not come from.
+        int first = targets[offsets[cell]];
+        int next = (first == prev) ? targets[offsets[cell] + 1] : first;
+        prev = cell;
+        cell = next;
+        length++;
+    }
+    edge.b = j.nodeAt[cell];
+    edge.length = length;
+    j.edges.push_back(edge);
+    j.adj[edge.a].push_back({edgeId, 0});
+    j.adj[edge.b].push_back({edgeId, 1});
+    j.maxEdgeLength = std::max(j.maxEdgeLength, length);
+}
 
-            if (ny == TUNNEL_ROW_INDEX) {
-                if (nx < 0) nx = COLS - 1;
-                else if (nx >= COLS) nx = 0;
-            }
+/**
+ * @brief Compiles a maze graph into its junction graph.
+ * @param graph The maze graph; it must outlive the junction graph.
+ */
+void buildJunctionGraph(JunctionGraph& j, const MazeGraph& graph) {
+    j.graph = &graph;
+    const int* offsets = graph.offsets.data();
+    const int* targets = graph.targets.data();
+    int cellCount = graph.width * graph.height;
+    j.nodeCells.clear();
+    j.edges.clear();
+    j.edgeCells.clear();
+    j.adj.clear();
+    j.nodeAt.assign(cellCount, -1);
+    j.edgeAt.assign(cellCount, -1);
+    j.offsetAt.assign(cellCount, 0);
+    j.maxEdgeLength = 1;
+    j.garbageCells = 0;
 
-            if (nx >= 0 && nx < COLS && ny >= 0 && ny < ROWS && maze[ny][nx] == TILE_PATH && !visited[ny][nx]) {
-                visited[ny][nx] = true;
-                parent[ny][nx][0] = x_bfs;
-                parent[ny][nx][1] = y_bfs;
-                q.push({nx, ny});
-                if (nx == playerX && ny == playerY) {
-                    targetX = nx;
-                    targetY = ny;
-                    found = true;
-                }
-            }
+    // Every path cell that is not a plain corridor cell becomes a node.
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (!j.graph->walkable[cell]) continue;
+        if (offsets[cell + 1] - offsets[cell] != 2) {
+            j.nodeAt[cell] = j.nodeCells.size();
+            j.nodeCells.push_back(cell);
         }
     }
+    j.adj.resize(j.nodeCells.size());
 
-    if (!found) return;
-
-    // Backtrack from the player to find the cat's next move
-    int cx = targetX;
-    int cy = targetY;
-    int nextStepX = -1, nextStepY = -1;
-    while(true){
-        if (cx == catX && cy == catY) break;
-        int px = parent[cy][cx][0];
-        int py = parent[cy][cx][1];
-        if (px == -1 && py == -1) break;
-        if (px == catX && py == catY) {
-            nextStepX = cx;
-            nextStepY = cy;
-            break;
+    for (int node = 0; node < (int)j.nodeCells.size(); ++node) {
+        int cell = j.nodeCells[node];
+        for (int i = offsets[cell]; i < offsets[cell + 1]; ++i) {
+            int next = targets[i];
+            int other = j.nodeAt[next];
+            if (other != -1) {
+                // Adjacent nodes: add the direct edge once, from the lower id.
+                if (node < other) walkJunctionEdge(j, node, next);
+            } else if (j.edgeAt[next] == -1) {
+                walkJunctionEdge(j, node, next);
+            }
         }
-        cx = px;
-        cy = py;
     }
 
-    // Update the cat's position if a valid step was found
-    if (nextStepX != -1) {
-        catX = nextStepX;
-        catY = nextStepY;
+    // Closed loops without any junction: promote one cell so the loop has an anchor.
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (!j.graph->walkable[cell] || j.nodeAt[cell] != -1 || j.edgeAt[cell] != -1) continue;
+        int node = j.nodeCells.size();
+        j.nodeAt[cell] = node;
+        j.nodeCells.push_back(cell);
+        j.adj.emplace_back();
+        walkJunctionEdge(j, node, targets[offsets[cell]]);
     }
 
-    // Check for collision with the player
-    if (catX == playerX && catY == playerY && currentGameState == PLAYING) {
-        std::cout << "Caught by the cat! Game Over. Current Level Score: " << score << std::endl;
-        totalScore += score;
-        score = 0;
-        currentGameState = GAME_OVER;
-        timerActive = false;
-        std::cout << "Final Total Score: " << totalScore << std::endl;
-    }
+    int nodeCount = j.nodeCells.size();
+    j.dist.assign(nodeCount, INT_MAX);
+    j.stamp.assign(nodeCount, 0);
+    j.settled.assign(nodeCount, false);
+    j.buckets.assign(j.maxEdgeLength + 1, std::vector<int>());
+    j.searchStamp = 0;
 }
 
 /**
- * @brief Timer callback that triggers the cat's movement periodically.
- * @param value A unique identifier to prevent multiple timers from running after a reset.
+ * @brief Removes an edge, frees its corridor cells and moves the last edge into its id.
+ * @param freed Receives the corridor cells, which no longer belong to any edge.
  */
-void catTimer(int value) {
-    if (value != resetIdentifier && currentGameState != START_MENU) {
-        return;
+void removeJunctionEdge(JunctionGraph& j, int edgeId, std::vector<int>& freed) {
+    const JunctionEdge e = j.edges[edgeId];
+    for (int i = 0; i < e.length - 1; ++i) {
+        int cell = j.edgeCells[e.firstCell + i];
+        j.edgeAt[cell] = -1;
+        j.offsetAt[cell] = 0;
+        freed.push_back(cell);
     }
-    if (currentGameState == PLAYING && timerActive) {
-        if (!isCatSlowed) {
-            moveCat();
+    j.garbageCells += e.length - 1;
+    for (int node : {e.a, e.b}) {
+        auto& adj = j.adj[node];
+        for (size_t i = 0; i < adj.size(); ++i) {
+            if (adj[i].first == edgeId) { adj[i] = adj.back(); adj.pop_back(); break; }
         }
-        glutTimerFunc(currentCatDelay, catTimer, resetIdentifier);
     }
+    int last = j.edges.size() - 1;
+    if (edgeId != last) {
+        const JunctionEdge& moved = j.edges[edgeId] = j.edges[last];
+        for (int node : {moved.a, moved.b}) {
+            for (auto& adj : j.adj[node]) if (adj.first == last) adj.first = edgeId;
+        }
+        for (int i = 0; i < moved.length - 1; ++i) j.edgeAt[j.edgeCells[moved.firstCell + i]] = edgeId;
+    }
+    j.edges.pop_back();
 }
 
-
-// -----------------------------------------------------------------------------
-// USER INPUT AND SYSTEM CALLBACKS
-// -----------------------------------------------------------------------------
+/**
+ * @brief Removes an edgeless node and moves the last node into its id.
+ */
+void removeJunctionNode(JunctionGraph& j, int node) {
+    j.nodeAt[j.nodeCells[node]] = -1;
+    int last = j.nodeCells.size() - 1;
+    if (node != last) {
+        j.nodeCells[node] = j.nodeCells[last];
+        j.nodeAt[j.nodeCells[node]] = node;
+        j.adj[node].swap(j.adj[last]);
+        for (const auto& adj : j.adj[node]) {
+            if (adj.second == 0) j.edges[adj.first].a = node;
+            else j.edges[adj.first].b = node;
+        }
+    }
+    j.nodeCells.pop_back();
+    j.adj.pop_back();
+}
 
 /**
- * @brief Handles all keyboard input from the user (ASCII characters).
- * @param key The ASCII value of the key pressed.
- * @param x_param Mouse X position (unused).
- * @param y_param Mouse Y position (unused).
+ * @brief Repairs the junction graph after patchMazeGraph() rebuilt the rows of `cells`.
+ * Only the edges running through those cells are removed and walked again, and only
+ * those cells can gain or lose their node; everything else keeps its id.
  */
-void keyboard(unsigned char key, int x_param, int y_param) {
-    // State machine for keyboard input
-    if (currentGameState == INTRO) {
-        currentGameState = START_MENU;
-        glutPostRedisplay();
-        return;
+void patchJunctionGraph(JunctionGraph& j, const std::vector<int>& cells) {
+    const int* offsets = j.graph->offsets.data();
+    const int* targets = j.graph->targets.data();
+    std::vector<int> dirty, touched(cells), freed;
+    for (int cell : cells) {
+        if (j.edgeAt[cell] != -1) dirty.push_back(j.edgeAt[cell]);
+        else if (j.nodeAt[cell] != -1) for (const auto& adj : j.adj[j.nodeAt[cell]]) dirty.push_back(adj.first);
     }
-    if (currentGameState == START_MENU) {
-        if (key == 13) { resetGame(); } // Enter key
-        else if (key == 27) { exit(0); } // Escape key
-        return;
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    for (int edgeId : dirty) {
+        touched.push_back(j.nodeCells[j.edges[edgeId].a]);
+        touched.push_back(j.nodeCells[j.edges[edgeId].b]);
     }
-    if (currentGameState == GAME_OVER || currentGameState == GAME_WON_FINAL || currentGameState == GAME_WON_LEVEL) {
-        if ((key == 'r' || key == 'R') && currentGameState != GAME_WON_FINAL) { resetGame(); }
-        else if (key == 27) { exit(0); }
-        return;
+    // Highest ids first, so the edge moved into a freed id is never one still to remove.
+    for (auto it = dirty.rbegin(); it != dirty.rend(); ++it) removeJunctionEdge(j, *it, freed);
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    // Re-decide which touched cells are nodes. Loop anchors (corridor cells promoted in
+    // buildJunctionGraph()) are dropped too and promoted again below if still needed.
+    for (size_t t = 0; t < touched.size(); ++t) { // Grows as demoted nodes hand over their neighbors.
+        int cell = touched[t];
+        bool isNode = j.graph->walkable[cell] && offsets[cell + 1] - offsets[cell] != 2;
+        int node = j.nodeAt[cell];
+        if (node != -1 && !isNode) {
+            while (!j.adj[node].empty()) {
+                const JunctionEdge& e = j.edges[j.adj[node].back().first];
+                touched.push_back(j.nodeCells[e.a == node ? e.b : e.a]);
+                removeJunctionEdge(j, j.adj[node].back().first, freed);
+            }
+            removeJunctionNode(j, node);
+            freed.push_back(cell);
+        } else if (node == -1 && isNode) {
+            j.nodeAt[cell] = j.nodeCells.size();
+            j.nodeCells.push_back(cell);
+            j.adj.emplace_back();
+        }
     }
 
-    // General controls (available in multiple states)
-    if (key == 'p' || key == 'P') {
-         if (currentGameState == PLAYING) {
-             currentGameState = PAUSED;
-             timerActive = false;
-             std::cout << "Game Paused.\n";
-             glutPostRedisplay();
-         } else if (currentGameState == PAUSED) {
-             currentGameState = PLAYING;
-             timerActive = true;
-             lastTickTime = glutGet(GLUT_ELAPSED_TIME);
-             resetIdentifier++;
-             catTimer(resetIdentifier);
-             std::cout << "Game Resumed.\n";
-             glutPostRedisplay();
-         }
-         return;
+    // Walk every way out of the touched nodes that is not already covered by an edge.
+    for (int cell : touched) {
+        int node = j.nodeAt[cell];
+        if (node == -1) continue;
+        for (int i = offsets[cell]; i < offsets[cell + 1]; ++i) {
+            int next = targets[i];
+            int other = j.nodeAt[next];
+            if (other != -1) {
+                bool linked = false;
+                for (const auto& adj : j.adj[node]) {
+                    const JunctionEdge& e = j.edges[adj.first];
+                    linked = linked || (e.length == 1 && (adj.second == 0 ? e.b : e.a) == other);
+                }
+                if (!linked) walkJunctionEdge(j, node, next);
+            } else if (j.edgeAt[next] == -1) {
+                walkJunctionEdge(j, node, next);
+            }
+        }
+    }
+    for (int cell : freed) {
+        if (!j.graph->walkable[cell] || j.nodeAt[cell] != -1 || j.edgeAt[cell] != -1) continue;
+        int node = j.nodeCells.size();
+        j.nodeAt[cell] = node;
+        j.nodeCells.push_back(cell);
+        j.adj.emplace_back();
+        walkJunctionEdge(j, node, targets[offsets[cell]]);
     }
-    if (key == 27) exit(0);
 
-    // Gameplay controls (only active when playing)
-    if (currentGameState != PLAYING) return;
-    if (key == 'r' || key == 'R') {
-        resetGame();
+    if (j.garbageCells > (int)j.edgeCells.size() / 2) {
+        buildJunctionGraph(j, *j.graph); // Compacts j.edgeCells.
         return;
     }
+    int nodeCount = j.nodeCells.size();
+    j.dist.resize(nodeCount, INT_MAX);
+    j.stamp.resize(nodeCount, 0);
+    j.settled.resize(nodeCount, false);
+    j.buckets.resize(j.maxEdgeLength + 1);
+}
 
-    int nextX = playerX, nextY = playerY;
-    switch (key) {
-        case 'w': case 'W': nextY--; break;
-        case 's': case 'S': nextY++; break;
-        case 'a': case 'A': nextX--; break;
-        case 'd': case 'D': nextX++; break;
-        default: return;
-    }
-    processPlayerMove(nextX, nextY);
+/**
+ * @brief Returns the cell at a given number of steps along an edge, measured from endpoint a.
+ */
+int junctionCellAtOffset(const JunctionGraph& j, int edgeId, int offset) {
+    const JunctionEdge& e = j.edges[edgeId];
+    if (offset <= 0) return j.nodeCells[e.a];
+    if (offset >= e.length) return j.nodeCells[e.b];
+    return j.edgeCells[e.firstCell + offset - 1];
 }
 
 /**
- * @brief Handles special keyboard input (e.g., arrow keys).
- * @param key The GLUT constant for the special key pressed.
- * @param x Mouse X position (unused).
- * @param y Mouse Y position (unused).
+ * @brief Finds the first step of a shortest path using the junction graph.
+ * Runs Dijkstra with a bucket queue (Dial's algorithm) from the target until every node
+ * adjacent to the start has been settled, then picks the best way out of the start cell.
+ * @param step Receives the next cell, or -1 if already at the target.
+ * @return True if the target is reachable.
  */
-void specialKeyboard(int key, int x, int y) {
-    if (currentGameState != PLAYING) return;
+bool junctionNextStep(JunctionGraph& j, int fromCell, int toCell, int& step) {
+    step = -1;
+    lastSearchNodesTouched = 0;
+    if (fromCell == toCell) return true;
+    if (!j.graph->walkable[fromCell] || !j.graph->walkable[toCell]) return false; // Neither is on any edge.
 
-    int nextX = playerX, nextY = playerY;
+    // A candidate way out of the start cell: leave along an edge towards one of its ends.
+    struct Exit { int edge; int nextOffset; int directCost; int viaNode; int viaCost; };
+    Exit exits[8];
+    int exitCount = 0;
+    int toEdge = j.edgeAt[toCell];
+    int toOffset = j.offsetAt[toCell];
+    int fromNode = j.nodeAt[fromCell];
+    if (fromNode != -1) {
+        for (const auto& adj : j.adj[fromNode]) {
+            const JunctionEdge& e = j.edges[adj.first];
+            bool forward = adj.second == 0;
+            Exit ex;
+            ex.edge = adj.first;
+            ex.nextOffset = forward ? 1 : e.length - 1;
+            ex.directCost = (toEdge == adj.first) ? (forward ? toOffset : e.length - toOffset) : INT_MAX;
+            ex.viaNode = forward ? e.b : e.a;
+            ex.viaCost = e.length;
+            exits[exitCount++] = ex;
+        }
+    } else {
+        int edgeId = j.edgeAt[fromCell];
+        int k = j.offsetAt[fromCell];
+        const JunctionEdge& e = j.edges[edgeId];
+        bool sameEdge = (toEdge == edgeId);
+        exits[exitCount++] = {edgeId, k - 1, (sameEdge && toOffset < k) ? k - toOffset : INT_MAX, e.a, k};
+        exits[exitCount++] = {edgeId, k + 1, (sameEdge && toOffset > k) ? toOffset - k : INT_MAX, e.b, e.length - k};
+    }
+
+    // Seed the search at the target: a node, or both ends of the target's corridor.
+    j.searchStamp++;
+    int bucketCount = j.buckets.size();
+    int pending = 0;
+    auto relax = [&](int node, int d) {
+        if (j.stamp[node] != j.searchStamp) {
+            j.stamp[node] = j.searchStamp;
+            j.dist[node] = INT_MAX;
+            j.settled[node] = false;
+        }
+        if (d < j.dist[node]) {
+            j.dist[node] = d;
+            j.buckets[d % bucketCount].push_back(node);
+            pending++;
+        }
+    };
+    int toNode = j.nodeAt[toCell];
+    if (toNode != -1) {
+        relax(toNode, 0);
+    } else {
+        relax(j.edges[toEdge].a, toOffset);
+        relax(j.edges[toEdge].b, j.edges[toEdge].length - toOffset);
+    }
+
+    // Nodes whose distances the exits depend on; the search stops once they are all settled.
+    int remainingTargets = 0;
+    for (int i = 0; i < exitCount; ++i) {
+        int node = exits[i].viaNode;
+        relax(node, INT_MAX); // Only stamps the node for this search.
+        bool duplicate = false;
+        for (int j = 0; j < i; ++j) duplicate = duplicate || exits[j].viaNode == node;
+        if (!duplicate) remainingTargets++;
+    }
+
+    for (int d = 0; pending > 0 && remainingTargets > 0; ++d) {
+        std::vector<int>& bucket = j.buckets[d % bucketCount];
+        while (!bucket.empty()) {
+            int node = bucket.back();
+            bucket.pop_back();
+            pending--;
+            if (j.settled[node] || j.dist[node] != d) continue;
+            j.settled[node] = true;
+            lastSearchNodesTouched++;
+            for (int i = 0; i < exitCount; ++i) {
+                if (exits[i].viaNode == node) { remainingTargets--; break; }
+            }
+            for (const auto& adj : j.adj[node]) {
+                const JunctionEdge& e = j.edges[adj.first];
+                relax(adj.second == 0 ? e.b : e.a, d + e.length);
+            }
+        }
+    }
+    for (auto& bucket : j.buckets) bucket.clear();
+
+    // Pick the exit with the shortest total distance to the target.
+    int bestCost = INT_MAX;
+    int bestExit = -1;
+    for (int i = 0; i < exitCount; ++i) {
+        int cost = exits[i].directCost;
+        int node = exits[i].viaNode;
+        if (j.settled[node] && j.dist[node] != INT_MAX) cost = std::min(cost, exits[i].viaCost + j.dist[node]);
+        if (cost < bestCost) { bestCost = cost; bestExit = i; }
+    }
+    if (bestExit == -1) return false;
+    step = junctionCellAtOffset(j, exits[bestExit].edge, exits[bestExit].nextOffset);
+    return true;
+}
+
+/**
+ * @brief Multi-source breadth-first distance field over any compiled maze graph.
+ * @param graph The maze graph to search.
+ * @param sources Cells at distance 0.
+ * @param dist Receives the step distance of every cell, or -1 if unreachable.
+ * @param stopCell If not -1, the search stops as soon as this cell is reached.
+ * @param owner If given, receives the index in sources of the nearest source of each cell.
+ * @return The number of cells expanded.
+ */
+int bfsDistanceField(const MazeGraph& graph, const std::vector<int>& sources, std::vector<int>& dist, int stopCell, std::vector<int>* owner = nullptr) {
+    const int* offsets = graph.offsets.data();
+    const int* targets = graph.targets.data();
+    int cellCount = graph.width * graph.height;
+    dist.assign(cellCount, -1);
+    if (owner) owner->assign(cellCount, -1);
+    std::vector<int> queue;
+    queue.reserve(cellCount);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        int s = sources[i];
+        if (dist[s] == -1) {
+            dist[s] = 0;
+            if (owner) (*owner)[s] = (int)i;
+            queue.push_back(s);
+        }
+    }
+    int expanded = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int current = queue[head];
+        if (current == stopCell) break;
+        expanded++;
+        for (int i = offsets[current]; i < offsets[current + 1]; ++i) {
+            int next = targets[i];
+            if (dist[next] == -1) {
+                dist[next] = dist[current] + 1;
+                if (owner) (*owner)[next] = (*owner)[current];
+                queue.push_back(next);
+            }
+        }
+    }
+    return expanded;
+}
+
+// --- Hierarchical Pathfinding (HPA*) ---
+// The grid is split into fixed-size square sectors. Walkable cells with a neighbor in
+// another sector are entrances; each sector caches the in-sector distances between its
+// entrances. Chasers plan over entrances only and refine one sector at a time.
+const int HPA_SECTOR_SIZE = 8;
+const int HPA_MAX_PLAN_EXPANSIONS = 4096; // Past this, a plan heads for the closest entrance found so far.
+
+struct HpaGraph {
+    const MazeGraph* graph = nullptr;
+    int sectorSize = 0, sectorsX = 0, sectorsY = 0;
+    int version = 0;                                // Bumped whenever any sector changes.
+    std::vector<std::vector<int>> sectorEntrances;  // Sector -> entrance cells.
+    std::vector<std::vector<int>> sectorDistances;  // Sector -> k * k in-sector distances between its entrances (-1 = none).
+    std::vector<int> entranceSlot;                  // Cell -> index in its sector's entrance list, or -1.
+    // Search scratch, stamped so nothing has to be cleared between queries.
+    std::vector<int> dist, parent, stamp;
+    std::vector<int> localDist, localParent, localQueue;
+    int searchStamp = 0;
+};
+
+struct HpaChaser {
+    std::vector<int> route; // Abstract waypoints, ending with the goal cell unless partial.
+    bool complete = true;   // False if the plan hit HPA_MAX_PLAN_EXPANSIONS before reaching the goal.
+    size_t next = 0;
+    int goalSector = -1;
+    int version = -1;
+};
+
+int hpaSectorOf(const HpaGraph& h, int cell) {
+    int x = cell % h.graph->width, y = cell / h.graph->width;
+    return (y / h.sectorSize) * h.sectorsX + (x / h.sectorSize);
+}
+
+int hpaLocalIndex(const HpaGraph& h, int cell) {
+    int x = cell % h.graph->width, y = cell / h.graph->width;
+    return (y % h.sectorSize) * h.sectorSize + (x % h.sectorSize);
+}
+
+/**
+ * @brief BFS restricted to one sector. Results land in h.localDist / h.localParent
+ * (indexed by hpaLocalIndex, -1 = unreachable), bounded by sectorSize^2 cells.
+ * @return The number of cells expanded.
+ */
+int hpaLocalBfs(HpaGraph& h, int source) {
+    const int* offsets = h.graph->offsets.data();
+    const int* targets = h.graph->targets.data();
+    int sector = hpaSectorOf(h, source);
+    std::fill(h.localDist.begin(), h.localDist.end(), -1);
+    h.localQueue.clear();
+    h.localDist[hpaLocalIndex(h, source)] = 0;
+    h.localParent[hpaLocalIndex(h, source)] = -1;
+    h.localQueue.push_back(source);
+    for (size_t head = 0; head < h.localQueue.size(); ++head) {
+        int current = h.localQueue[head];
+        int currentDist = h.localDist[hpaLocalIndex(h, current)];
+        for (int i = offsets[current]; i < offsets[current + 1]; ++i) {
+            int next = targets[i];
+            if (hpaSectorOf(h, next) != sector) continue;
+            int local = hpaLocalIndex(h, next);
+            if (h.localDist[local] != -1) continue;
+            h.localDist[local] = currentDist + 1;
+            h.localParent[local] = current;
+            h.localQueue.push_back(next);
+        }
+    }
+    return h.localQueue.size();
+}
+
+/**
+ * @brief Recomputes the entrances and cached entrance distances of one sector.
+ */
+void hpaRebuildSector(HpaGraph& h, int sector) {
+    const MazeGraph& g = *h.graph;
+    int x0 = (sector % h.sectorsX) * h.sectorSize, y0 = (sector / h.sectorsX) * h.sectorSize;
+    int x1 = std::min(x0 + h.sectorSize, g.width), y1 = std::min(y0 + h.sectorSize, g.height);
+    std::vector<int>& entrances = h.sectorEntrances[sector];
+    for (int cell : entrances) h.entranceSlot[cell] = -1;
+    entrances.clear();
+    for (int y = y0; y < y1; ++y) {
+        for (int x = x0; x < x1; ++x) {
+            int cell = y * g.width + x;
+            for (int i = g.offsets[cell]; i < g.offsets[cell + 1]; ++i) {
+                if (hpaSectorOf(h, g.targets[i]) != sector) {
+                    h.entranceSlot[cell] = entrances.size();
+                    entrances.push_back(cell);
+                    break;
+                }
+            }
+        }
+    }
+    int k = entrances.size();
+    std::vector<int>& distances = h.sectorDistances[sector];
+    distances.assign(k * k, -1);
+    for (int i = 0; i < k; ++i) {
+        hpaLocalBfs(h, entrances[i]);
+        for (int j = 0; j < k; ++j) distances[i * k + j] = h.localDist[hpaLocalIndex(h, entrances[j])];
+    }
+    h.version++;
+}
+
+/**
+ * @brief Builds the sector abstraction for a compiled maze graph.
+ * @param h The abstraction to (re)build.
+ * @param graph The maze graph; it must outlive the abstraction.
+ * @param sectorSize The side length of each square sector, in cells.
+ */
+void hpaBuild(HpaGraph& h, const MazeGraph& graph, int sectorSize) {
+    int cellCount = graph.width * graph.height;
+    h.graph = &graph;
+    h.sectorSize = sectorSize;
+    h.sectorsX = (graph.width + sectorSize - 1) / sectorSize;
+    h.sectorsY = (graph.height + sectorSize - 1) / sectorSize;
+    h.sectorEntrances.assign(h.sectorsX * h.sectorsY, std::vector<int>());
+    h.sectorDistances.assign(h.sectorsX * h.sectorsY, std::vector<int>());
+    h.entranceSlot.assign(cellCount, -1);
+    h.dist.assign(cellCount, 0);
+    h.parent.assign(cellCount, -1);
+    h.stamp.assign(cellCount, 0);
+    h.localDist.assign(sectorSize * sectorSize, -1);
+    h.localParent.assign(sectorSize * sectorSize, -1);
+    h.searchStamp = 0;
+    for (int sector = 0; sector < h.sectorsX * h.sectorsY; ++sector) hpaRebuildSector(h, sector);
+}
+
+/**
+ * @brief Refreshes only the sectors affected by a tile change at one cell.
+ * Call after the maze graph has been recompiled with the new tile.
+ */
+void hpaUpdateCell(HpaGraph& h, int cell) {
+    const MazeGraph& g = *h.graph;
+    int x = cell % g.width, y = cell / g.width;
+    std::vector<int> sectors = {hpaSectorOf(h, cell)};
+    for (int dir = 0; dir < 4; ++dir) {
+        int nx = x + DIR_DX[dir], ny = y + DIR_DY[dir];
+        if (nx >= 0 && nx < g.width && ny >= 0 && ny < g.height) sectors.push_back(hpaSectorOf(h, ny * g.width + nx));
+    }
+    for (int i = g.offsets[cell]; i < g.offsets[cell + 1]; ++i) sectors.push_back(hpaSectorOf(h, g.targets[i]));
+    std::sort(sectors.begin(), sectors.end());
+    sectors.erase(std::unique(sectors.begin(), sectors.end()), sectors.end());
+    for (int sector : sectors) hpaRebuildSector(h, sector);
+}
+
+/**
+ * @brief Plans an abstract route over sector entrances. The search settles at most
+ * HPA_MAX_PLAN_EXPANSIONS entrances; if it runs out before finding the goal, the route
+ * ends at the settled entrance closest to the goal in a straight line instead.
+ * @param route Receives the waypoints after start, ending with goal if complete.
+ * @param complete Receives whether the route reaches the goal.
+ * @return True if the goal is reachable, or may be past the expansion cap.
+ */
+bool hpaPlan(HpaGraph& h, int start, int goal, std::vector<int>& route, bool& complete) {
+    const MazeGraph& g = *h.graph;
+    int startSector = hpaSectorOf(h, start), goalSector = hpaSectorOf(h, goal);
+    route.clear();
+    complete = true;
+    lastSearchNodesTouched = 0;
+
+    // Connect the goal to its sector's entrances (BFS is symmetric: portals are two-way).
+    lastSearchNodesTouched += hpaLocalBfs(h, goal);
+    const std::vector<int>& goalEntrances = h.sectorEntrances[goalSector];
+    std::vector<int> goalDist(goalEntrances.size());
+    for (size_t i = 0; i < goalEntrances.size(); ++i) goalDist[i] = h.localDist[hpaLocalIndex(h, goalEntrances[i])];
+    int best = (startSector == goalSector) ? h.localDist[hpaLocalIndex(h, start)] : -1;
+    if (best == -1) best = INT_MAX;
+    int bestLast = -1; // Last entrance before the goal; -1 means a direct in-sector path.
+
+    // Connect the start to its sector's entrances and seed the abstract search.
+    lastSearchNodesTouched += hpaLocalBfs(h, start);
+    h.searchStamp++;
+    typedef std::pair<int, int> QueueEntry; // (distance, cell)
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open;
+    auto relax = [&](int cell, int d, int from) {
+        if (h.stamp[cell] != h.searchStamp || d < h.dist[cell]) {
+            h.stamp[cell] = h.searchStamp;
+            h.dist[cell] = d;
+            h.parent[cell] = from;
+            open.push({d, cell});
+        }
+    };
+    for (int e : h.sectorEntrances[startSector]) {
+        int d = h.localDist[hpaLocalIndex(h, e)];
+        if (d != -1) relax(e, d, -1);
+    }
+
+    int expanded = 0, closest = -1, closestGap = INT_MAX;
+    bool capped = false;
+    while (!open.empty()) {
+        QueueEntry top = open.top();
+        open.pop();
+        int d = top.first, u = top.second;
+        if (d != h.dist[u]) continue;
+        if (d >= best) break;
+        if (++expanded > HPA_MAX_PLAN_EXPANSIONS) { capped = true; break; }
+        lastSearchNodesTouched++;
+        int gap = std::abs(u % g.width - goal % g.width) + std::abs(u / g.width - goal / g.width);
+        if (u != start && gap < closestGap) { closest = u; closestGap = gap; }
+        int sector = hpaSectorOf(h, u);
+        int slot = h.entranceSlot[u];
+        if (sector == goalSector && goalDist[slot] != -1 && d + goalDist[slot] < best) {
+            best = d + goalDist[slot];
+            bestLast = u;
+        }
+        const std::vector<int>& entrances = h.sectorEntrances[sector];
+        const std::vector<int>& distances = h.sectorDistances[sector];
+        int k = entrances.size();
+        for (int j = 0; j < k; ++j) {
+            int w = distances[slot * k + j];
+            if (w > 0) relax(entrances[j], d + w, u);
+        }
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; ++i) {
+            int v = g.targets[i];
+            if (hpaSectorOf(h, v) != sector) relax(v, d + 1, u);
+        }
+    }
+    if (best == INT_MAX && (!capped || closest == -1)) return false;
+
+    // A path found before the cap stands even if it might not be the shortest.
+    complete = (best != INT_MAX);
+    for (int cell = complete ? bestLast : closest; cell != -1; cell = h.parent[cell]) route.push_back(cell);
+    std::reverse(route.begin(), route.end());
+    if (!route.empty() && route.front() == start) route.erase(route.begin());
+    if (complete && (route.empty() || route.back() != goal)) route.push_back(goal);
+    return true;
+}
+
+/**
+ * @brief Refines one step from a cell towards a waypoint in the same or an adjacent sector.
+ * @return True if a step was found.
+ */
+bool hpaStepToward(HpaGraph& h, int from, int waypoint, int& step) {
+    const MazeGraph& g = *h.graph;
+    if (hpaSectorOf(h, from) != hpaSectorOf(h, waypoint)) {
+        // Crossing a sector border: the waypoint must be a direct neighbor.
+        for (int i = g.offsets[from]; i < g.offsets[from + 1]; ++i) {
+            if (g.targets[i] == waypoint) { step = waypoint; return true; }
+        }
+        return false;
+    }
+    lastSearchNodesTouched += hpaLocalBfs(h, from);
+    if (h.localDist[hpaLocalIndex(h, waypoint)] == -1) return false;
+    int cell = waypoint;
+    while (h.localParent[hpaLocalIndex(h, cell)] != from) cell = h.localParent[hpaLocalIndex(h, cell)];
+    step = cell;
+    return true;
+}
+
+/**
+ * @brief Finds a chaser's next step using the sector abstraction.
+ * The abstract route is cached in the chaser and only replanned when the goal changes
+ * sector, the abstraction changes, refinement fails or a partial route runs out, so most
+ * ticks cost a single in-sector BFS regardless of maze size, and no tick settles more
+ * than HPA_MAX_PLAN_EXPANSIONS entrances.
+ * @param step Receives the next cell, or -1 if already at the goal.
+ * @return True if the goal is reachable.
+ */
+bool hpaNextStep(HpaGraph& h, HpaChaser& chaser, int from, int goal, int& step) {
+    step = -1;
+    lastSearchNodesTouched = 0;
+    if (from == goal) return true;
+    bool replan = chaser.route.empty() || chaser.goalSector != hpaSectorOf(h, goal) || chaser.version != h.version;
+    for (int attempt = 0; attempt < 2; ++attempt, replan = true) {
+        if (replan) {
+            if (!hpaPlan(h, from, goal, chaser.route, chaser.complete)) return false;
+            chaser.next = 0;
+            chaser.goalSector = hpaSectorOf(h, goal);
+            chaser.version = h.version;
+        } else if (chaser.complete) {
+            chaser.route.back() = goal; // The goal moved within its sector.
+        }
+        while (chaser.next < chaser.route.size() && chaser.route[chaser.next] == from) chaser.next++;
+        if (chaser.next < chaser.route.size() && hpaStepToward(h, from, chaser.route[chaser.next], step)) return true;
+    }
+    return false;
+}
+
+// --- D* Lite Incremental Replanning ---
+// Each chaser keeps its own search state, rooted at the goal (the player). When the
+// chaser moves, only the key modifier km changes; when the player steps or a tile
+// toggles, only the affected vertices are updated and the search repairs from there.
+const int DSTAR_INFINITY = INT_MAX / 4;
+
+struct DStarPlanner {
+    const MazeGraph* graph = nullptr;
+    std::vector<Portal> portals; // Used by the heuristic only.
+    int start = -1, goal = -1, last = -1;
+    int km = 0;
+    std::vector<int> g, rhs;
+    typedef std::pair<std::pair<int, int>, int> QueueEntry; // (key, cell)
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> open;
+    long long expansions = 0; // Total vertices expanded since initialization.
+};
+
+/**
+ * @brief Admissible distance estimate: free-space Manhattan distance, allowing one portal hop.
+ * With more than one portal a chain of hops could be shorter, so the estimate drops to 0.
+ */
+int dstarHeuristic(const DStarPlanner& p, int a, int b) {
+    if (p.portals.size() > 1) return 0;
+    int w = p.graph->width;
+    auto manhattan = [w](int ax, int ay, int bx, int by) { return std::abs(ax - bx) + std::abs(ay - by); };
+    int ax = a % w, ay = a / w, bx = b % w, by = b / w;
+    int best = manhattan(ax, ay, bx, by);
+    for (const auto& portal : p.portals) {
+        best = std::min(best, manhattan(ax, ay, portal.x, portal.y) + 1 + manhattan(portal.toX, portal.toY, bx, by));
+        best = std::min(best, manhattan(ax, ay, portal.toX, portal.toY) + 1 + manhattan(portal.x, portal.y, bx, by));
+    }
+    return best;
+}
+
+std::pair<int, int> dstarKey(const DStarPlanner& p, int cell) {
+    int m = std::min(p.g[cell], p.rhs[cell]);
+    return {m + dstarHeuristic(p, p.start, cell) + p.km, m};
+}
+
+void dstarUpdateVertex(DStarPlanner& p, int cell) {
+    const MazeGraph& graph = *p.graph;
+    if (cell != p.goal) {
+        int best = DSTAR_INFINITY;
+        for (int i = graph.offsets[cell]; i < graph.offsets[cell + 1]; ++i) best = std::min(best, p.g[graph.targets[i]] + 1);
+        p.rhs[cell] = graph.walkable[cell] ? best : DSTAR_INFINITY;
+    }
+    if (p.g[cell] != p.rhs[cell]) p.open.push({dstarKey(p, cell), cell});
+}
+
+/**
+ * @brief Expands inconsistent vertices until the chaser's own cell is consistent.
+ * The queue uses lazy deletion: entries whose key is out of date are re-queued or dropped.
+ */
+void dstarComputeShortestPath(DStarPlanner& p) {
+    const MazeGraph& graph = *p.graph;
+    while (!p.open.empty()) {
+        DStarPlanner::QueueEntry top = p.open.top();
+        if (!(top.first < dstarKey(p, p.start) || p.rhs[p.start] != p.g[p.start])) break;
+        p.open.pop();
+        int u = top.second;
+        if (p.g[u] == p.rhs[u]) continue;
+        std::pair<int, int> key = dstarKey(p, u);
+        if (top.first < key) { p.open.push({key, u}); continue; }
+        if (key < top.first) continue; // A newer entry with the current key is queued.
+        p.expansions++;
+        if (p.g[u] > p.rhs[u]) {
+            p.g[u] = p.rhs[u];
+        } else {
+            p.g[u] = DSTAR_INFINITY;
+            dstarUpdateVertex(p, u);
+        }
+        for (int i = graph.offsets[u]; i < graph.offsets[u + 1]; ++i) dstarUpdateVertex(p, graph.targets[i]);
+    }
+}
+
+/**
+ * @brief Discards all search state and roots a fresh search at the goal.
+ */
+void dstarInit(DStarPlanner& p, const MazeGraph& graph, const std::vector<Portal>& portals, int start, int goal) {
+    int cellCount = graph.width * graph.height;
+    p.graph = &graph;
+    p.portals = portals;
+    p.start = p.last = start;
+    p.goal = goal;
+    p.km = 0;
+    p.g.assign(cellCount, DSTAR_INFINITY);
+    p.rhs.assign(cellCount, DSTAR_INFINITY);
+    p.open = decltype(p.open)();
+    p.expansions = 0;
+    p.rhs[goal] = 0;
+    p.open.push({dstarKey(p, goal), goal});
+}
+
+/**
+ * @brief Tells a planner that the adjacency of some cells changed (e.g. a door toggled).
+ * Pass the toggled cell together with every cell that was or is now linked to it.
+ */
+void dstarNotifyChanged(DStarPlanner& p, const std::vector<int>& cells) {
+    if (p.graph == nullptr) return;
+    for (int cell : cells) dstarUpdateVertex(p, cell);
+}
+
+/**
+ * @brief Finds a chaser's next step, repairing the previous search instead of restarting it.
+ * @param step Receives the next cell, or -1 if already at the goal.
+ * @return True if the goal is reachable.
+ */
+bool dstarNextStep(DStarPlanner& p, int start, int goal, int& step) {
+    step = -1;
+    long long expansionsBefore = p.expansions;
+    if (start != p.start) {
+        p.km += dstarHeuristic(p, p.last, start);
+        p.last = p.start = start;
+    }
+    if (goal != p.goal) {
+        int oldGoal = p.goal;
+        p.goal = goal;
+        p.rhs[goal] = 0;
+        dstarUpdateVertex(p, goal);
+        dstarUpdateVertex(p, oldGoal);
+    }
+    dstarComputeShortestPath(p);
+    lastSearchNodesTouched = p.expansions - expansionsBefore;
+    if (start == goal) return true;
+    if (p.rhs[start] >= DSTAR_INFINITY) return false;
+
+    const MazeGraph& graph = *p.graph;
+    int best = DSTAR_INFINITY;
+    for (int i = graph.offsets[start]; i < graph.offsets[start + 1]; ++i) {
+        int next = graph.targets[i];
+        if (p.g[next] + 1 < best) { best = p.g[next] + 1; step = next; }
+    }
+    return step != -1;
+}
+
+// --- Worker Pool ---
+// A fixed set of threads that run one parallel-for style task at a time.
+// The calling thread takes part as worker 0, so a pool of size 1 runs everything inline.
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    std::function<void(int)> task;
+    int generation = 0;
+    int running = 0;
+    bool stopping = false;
+};
+
+int poolSize(const WorkerPool& pool) { return pool.threads.size() + 1; }
+
+/**
+ * @brief Starts a pool with the given total worker count (0 = one per hardware thread).
+ */
+void poolStart(WorkerPool& pool, int workerCount) {
+    if (workerCount <= 0) workerCount = std::max(1u, std::thread::hardware_concurrency());
+    for (int index = 1; index < workerCount; ++index) {
+        pool.threads.emplace_back([&pool, index]() {
+            int seen = 0;
+            std::unique_lock<std::mutex> lock(pool.mutex);
+            while (true) {
+                pool.wake.wait(lock, [&]() { return pool.stopping || pool.generation != seen; });
+                if (pool.stopping) return;
+                seen = pool.generation;
+                lock.unlock();
+                pool.task(index);
+                lock.lock();
+                if (--pool.running == 0) pool.done.notify_one();
+            }
+        });
+    }
+}
+
+/**
+ * @brief Runs task(workerIndex) once on every worker and blocks until all have finished.
+ */
+void poolRun(WorkerPool& pool, const std::function<void(int)>& task) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.task = task;
+        pool.running = pool.threads.size();
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+    task(0);
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done.wait(lock, [&]() { return pool.running == 0; });
+}
+
+void poolStop(WorkerPool& pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stopping = true;
+    }
+    pool.wake.notify_all();
+    for (auto& t : pool.threads) t.join();
+    pool.threads.clear();
+    pool.stopping = false;
+}
+
+// --- Direction-Optimizing Parallel BFS ---
+// Level-synchronous BFS that expands top-down from the frontier while it is small and
+// switches to bottom-up sweeps over the unvisited cells while it is large. Frontiers
+// smaller than PARALLEL_BFS_MIN_FRONTIER are expanded on the calling thread, because
+// maze wavefronts are often only a few cells wide and a pool dispatch would cost more.
+const int PARALLEL_BFS_MIN_FRONTIER = 2048;
+const int PARALLEL_BFS_ALPHA = 14; // Go bottom-up when frontier > unvisited / ALPHA.
+const int PARALLEL_BFS_BETA = 24;  // Return top-down when frontier < cells / BETA.
+
+/**
+ * @brief Computes the same distance field as bfsDistanceField(), using the worker pool.
+ * @param dist Receives the step distance of every cell, or -1 if unreachable.
+ * @return The number of BFS levels.
+ */
+int parallelBfsDistanceField(WorkerPool& pool, const MazeGraph& graph, int source, std::vector<int>& dist) {
+    const int* offsets = graph.offsets.data();
+    const int* targets = graph.targets.data();
+    int cellCount = graph.width * graph.height;
+    int wordCount = (cellCount + 63) / 64;
+    int workers = poolSize(pool);
+    dist.assign(cellCount, -1);
+    // Walls and the padding past the last cell start out "visited", so every clear bit
+    // is a walkable cell that still needs a distance.
+    std::vector<std::atomic<uint64_t>> visited(wordCount);
+    for (int w = 0; w < wordCount; ++w) {
+        uint64_t blocked = 0;
+        for (int bit = 0; bit < 64; ++bit) {
+            int cell = w * 64 + bit;
+            if (cell >= cellCount || !graph.walkable[cell]) blocked |= 1ull << bit;
+        }
+        visited[w].store(blocked, std::memory_order_relaxed);
+    }
+    std::vector<uint64_t> frontierBits(wordCount), nextBits(wordCount);
+    std::vector<std::vector<int>> localNext(workers);
+    std::vector<int> frontier = {source};
+    int* distData = dist.data();
+    dist[source] = 0;
+    visited[source / 64].fetch_or(1ull << (source % 64), std::memory_order_relaxed);
+    long long unvisited = 0;
+    for (int cell = 0; cell < cellCount; ++cell) unvisited += graph.walkable[cell];
+    unvisited--;
+    bool bottomUp = false;
+    int level = 0;
+
+    while (!frontier.empty()) {
+        long long frontierSize = frontier.size();
+        // A sweep costs a pass over the whole bitmap, so it also needs a large frontier in absolute terms.
+        if (!bottomUp && frontierSize > unvisited / PARALLEL_BFS_ALPHA && frontierSize >= PARALLEL_BFS_MIN_FRONTIER) bottomUp = true;
+        else if (bottomUp && frontierSize < cellCount / PARALLEL_BFS_BETA) bottomUp = false;
+        for (auto& next : localNext) next.clear();
+
+        if (bottomUp) {
+            std::fill(frontierBits.begin(), frontierBits.end(), 0);
+            for (int cell : frontier) frontierBits[cell / 64] |= 1ull << (cell % 64);
+            // Each worker owns a contiguous range of bitmap words, so writes never overlap.
+            poolRun(pool, [&](int t) {
+                int wordBegin = (long long)wordCount * t / workers, wordEnd = (long long)wordCount * (t + 1) / workers;
+                for (int w = wordBegin; w < wordEnd; ++w) {
+                    uint64_t seen = visited[w].load(std::memory_order_relaxed);
+                    for (uint64_t open = ~seen; open != 0; open &= open - 1) {
+                        int bit = __builtin_ctzll(open);
+                        int v = w * 64 + bit;
+                        for (int i = offsets[v]; i < offsets[v + 1]; ++i) {
+                            int u = targets[i];
+                            if (frontierBits[u / 64] >> (u % 64) & 1) {
+                                distData[v] = level + 1;
+                                seen |= 1ull << bit;
+                                localNext[t].push_back(v);
+                                break;
+                            }
+                        }
+                    }
+                    visited[w].store(seen, std::memory_order_relaxed);
+                }
+            });
+        } else if (frontierSize < PARALLEL_BFS_MIN_FRONTIER || workers == 1) {
+            for (int u : frontier) {
+                for (int i = offsets[u]; i < offsets[u + 1]; ++i) {
+                    int v = targets[i];
+                    uint64_t mask = 1ull << (v % 64);
+                    uint64_t word = visited[v / 64].load(std::memory_order_relaxed);
+                    if (word & mask) continue;
+                    visited[v / 64].store(word | mask, std::memory_order_relaxed); // No other thread is running.
+                    distData[v] = level + 1;
+                    localNext[0].push_back(v);
+                }
+            }
+        } else {
+            poolRun(pool, [&](int t) {
+                size_t begin = frontier.size() * t / workers, end = frontier.size() * (t + 1) / workers;
+                for (size_t f = begin; f < end; ++f) {
+                    int u = frontier[f];
+                    for (int i = offsets[u]; i < offsets[u + 1]; ++i) {
+                        int v = targets[i];
+                        uint64_t mask = 1ull << (v % 64);
+                        if (visited[v / 64].load(std::memory_order_relaxed) & mask) continue;
+                        // Only the worker that flips the bit claims the cell.
+                        if (visited[v / 64].fetch_or(mask, std::memory_order_relaxed) & mask) continue;
+                        distData[v] = level + 1;
+                        localNext[t].push_back(v);
+                    }
+                }
+            });
+        }
+
+        frontier.clear();
+        for (const auto& next : localNext) frontier.insert(frontier.end(), next.begin(), next.end());
+        unvisited -= frontier.size();
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief Precomputes one distance field per source, spreading whole searches across the pool.
+ * This is the fastest way to build many maps at once, since each search stays serial.
+ */
+void parallelDistanceFields(WorkerPool& pool, const MazeGraph& graph, const std::vector<int>& sources, std::vector<std::vector<int>>& fields) {
+    fields.resize(sources.size());
+    std::atomic<size_t> nextSource(0);
+    poolRun(pool, [&](int) {
+        for (size_t i = nextSource++; i < sources.size(); i = nextSource++) {
+            bfsDistanceField(graph, {sources[i]}, fields[i], -1);
+        }
+    });
+}
+
+// --- Bidirectional BFS ---
+// Searches from both ends with bitset visited sets, always expanding the smaller
+// frontier by one full layer, and stops as soon as the two sides meet. The forward
+// side remembers through which neighbor of the start each cell was first reached,
+// so the first step is known at the meeting cell without walking a parent chain.
+std::vector<uint64_t> bidiForwardSeen, bidiBackwardSeen;
+std::vector<int> bidiFirstStep;
+std::vector<int> bidiForward, bidiBackward, bidiNext;
+
+/**
+ * @brief Finds the first step of a shortest path from one cell to another.
+ * @param step Receives the next cell, or -1 if already at the target.
+ * @return True if the target is reachable.
+ */
+bool bidirectionalNextStep(const MazeGraph& graph, int from, int to, int& step) {
+    const int* offsets = graph.offsets.data();
+    const int* targets = graph.targets.data();
+    step = -1;
+    lastSearchNodesTouched = 0;
+    if (from == to) return true;
+    int wordCount = (graph.width * graph.height + 63) / 64;
+    bidiForwardSeen.assign(wordCount, 0);
+    bidiBackwardSeen.assign(wordCount, 0);
+    bidiFirstStep.resize(graph.width * graph.height);
+    auto seen = [](const std::vector<uint64_t>& bits, int cell) { return (bits[cell / 64] >> (cell % 64)) & 1; };
+    auto mark = [](std::vector<uint64_t>& bits, int cell) { bits[cell / 64] |= 1ull << (cell % 64); };
+
+    bidiForward.assign(1, from);
+    bidiBackward.assign(1, to);
+    mark(bidiForwardSeen, from);
+    mark(bidiBackwardSeen, to);
+
+    // The first meeting found is on a shortest path: the side being expanded is one layer
+    // short of the other side's newest layer, so every meeting in this layer has equal length.
+    while (!bidiForward.empty() && !bidiBackward.empty()) {
+        bool forward = bidiForward.size() <= bidiBackward.size();
+        std::vector<int>& frontier = forward ? bidiForward : bidiBackward;
+        std::vector<uint64_t>& ownSeen = forward ? bidiForwardSeen : bidiBackwardSeen;
+        const std::vector<uint64_t>& otherSeen = forward ? bidiBackwardSeen : bidiForwardSeen;
+        bidiNext.clear();
+        for (int u : frontier) {
+            lastSearchNodesTouched++;
+            for (int i = offsets[u]; i < offsets[u + 1]; ++i) {
+                int v = targets[i];
+                if (seen(ownSeen, v)) continue;
+                if (forward) {
+                    bidiFirstStep[v] = (u == from) ? v : bidiFirstStep[u];
+                    if (seen(otherSeen, v)) { step = bidiFirstStep[v]; return true; }
+                } else if (seen(otherSeen, v)) {
+                    step = (v == from) ? u : bidiFirstStep[v];
+                    return true;
+                }
+                mark(ownSeen, v);
+                bidiNext.push_back(v);
+            }
+        }
+        frontier.swap(bidiNext);
+    }
+    return false;
+}
+
+// --- Predictive Chaser AI ---
+// Instead of chasing the player's current cell, the cat runs an iterative-deepening
+// expectimax search: the cat maximizes, the player is a chance node that prefers
+// moves away from the cat. Leaves are scored with the level's all-pairs distance table.
+// Root moves are spread across the AI worker pool, and the search stops at a deadline
+// derived from currentCatDelay, returning the best move of the last finished depth.
+const int PREDICTIVE_CAPTURE_SCORE = 1000;
+const float PREDICTIVE_BUDGET_FRACTION = 0.25f; // Share of the cat's tick spent thinking.
+const int PREDICTIVE_MAX_BUDGET_MS = 40;         // Keeps rendering and input responsive.
+const int PREDICTIVE_MAX_DEPTH = 24;
+
+std::vector<int16_t> levelDistances; // cells * cells step distances, -1 if unreachable.
+bool levelDistancesReady = false;     // Built lazily: only some features read the table.
+// Tables of recently loaded layouts, keyed by mazeGraphHash(), so switching back to a
+// level (a reset, or replays hopping between levels) skips the all-pairs BFS.
+const size_t LEVEL_DISTANCE_CACHE_SIZE = 8;
+std::vector<std::pair<uint64_t, std::vector<int16_t>>> levelDistanceCache;
+WorkerPool aiPool;
+bool aiPoolStarted = false;
+
+/**
+ * @brief The worker pool shared by in-game AI work, started on first use.
+ */
+WorkerPool& sharedAiPool() {
+    if (!aiPoolStarted) {
+        poolStart(aiPool, 0);
+        aiPoolStarted = true;
+        atexit([]() { poolStop(aiPool); });
+    }
+    return aiPool;
+}
+
+/**
+ * @brief Fills the all-pairs distance table for the current maze graph, reusing the
+ * cached table when this layout was loaded recently.
+ */
+void buildLevelDistances() {
+    levelDistancesReady = true;
+    uint64_t hash = mazeGraphHash(mazeGraph);
+    for (const auto& entry : levelDistanceCache) {
+        if (entry.first == hash) { levelDistances = entry.second; return; }
+    }
+    int cellCount = mazeGraph.width * mazeGraph.height;
+    levelDistances.assign((size_t)cellCount * cellCount, -1);
+    std::vector<int> dist;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (!mazeGraph.walkable[cell]) continue;
+        bfsDistanceField(mazeGraph, {cell}, dist, -1);
+        for (int other = 0; other < cellCount; ++other) levelDistances[(size_t)cell * cellCount + other] = dist[other];
+    }
+    if (levelDistanceCache.size() == LEVEL_DISTANCE_CACHE_SIZE) levelDistanceCache.erase(levelDistanceCache.begin());
+    levelDistanceCache.emplace_back(hash, levelDistances);
+}
+
+/**
+ * @brief True if the chosen cat, ambushers or item placement read the distance table,
+ * so it is worth building as soon as a layout loads.
+ */
+bool levelDistancesNeeded() {
+    return catPathfinder == PATHFINDER_PREDICTIVE || !ambusherPersonalities.empty() || optimizeItemPlacement;
+}
+
+/**
+ * @brief Drops the table for a new or changed layout; it is rebuilt now only if needed.
+ */
+void resetLevelDistances() {
+    levelDistancesReady = false;
+    levelDistances.clear();
+    if (levelDistancesNeeded()) buildLevelDistances();
+}
+
+/**
+ * @brief Builds the table on first use. Call on the main thread before any levelDistance().
+ */
+void ensureLevelDistances() {
+    if (!levelDistancesReady) buildLevelDistances();
+}
+
+int levelDistance(int a, int b) {
+    return levelDistances[(size_t)a * mazeGraph.width * mazeGraph.height + b];
+}
+
+struct PredictiveContext {
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t baseKey = 0; // Game-state hash with the live cat and player keys removed.
+    long long nodes = 0;
+    long long tableHits = 0;
+    bool aborted = false;
+};
+
+// Chance-node values shared by all search threads; keys are only valid for one maze, so
+// the table is cleared whenever the level's pathfinding data is rebuilt.
+TranspositionTable predictiveTable;
+const int PREDICTIVE_TABLE_SIZE_LOG2 = 18;
+long long lastSearchTableHits = 0;
+
+double predictiveCatNode(int cat, int player, int depth, PredictiveContext& ctx);
+
+/**
+ * @brief Chance node: the player stays or steps, favoring moves that gain distance from the cat.
+ */
+double predictivePlayerNode(int cat, int player, int depth, PredictiveContext& ctx) {
+    if ((++ctx.nodes & 127) == 0 && std::chrono::steady_clock::now() >= ctx.deadline) ctx.aborted = true;
+    if (ctx.aborted) return 0.0;
+    uint64_t key = ctx.baseKey ^ zobristCat[cat] ^ zobristPlayer[player] ^ zobristChanceNode ^ zobristSearchDepth[depth];
+    float cached;
+    if (ttProbe(predictiveTable, key, cached)) {
+        ++ctx.tableHits;
+        return cached;
+    }
+    int here = levelDistance(cat, player);
+    double total = 0.0, weightSum = 0.0;
+    for (int i = mazeGraph.offsets[player] - 1; i < mazeGraph.offsets[player + 1]; ++i) {
+        int next = (i < mazeGraph.offsets[player]) ? player : mazeGraph.targets[i]; // First option: stay.
+        int gain = levelDistance(cat, next) - here;
+        double weight = (gain > 0) ? 3.0 : (gain == 0 ? 1.0 : 0.5);
+        double value = (next == cat) ? PREDICTIVE_CAPTURE_SCORE + depth : predictiveCatNode(cat, next, depth - 1, ctx);
+        total += weight * value;
+        weightSum += weight;
+    }
+    if (!ctx.aborted) ttStore(predictiveTable, key, (float)(total / weightSum));
+    return total / weightSum;
+}
+
+/**
+ * @brief Max node: the cat picks its best step, or the leaf is scored by distance.
+ */
+double predictiveCatNode(int cat, int player, int depth, PredictiveContext& ctx) {
+    if (depth == 0) {
+        int d = levelDistance(cat, player);
+        return (d < 0) ? -PREDICTIVE_CAPTURE_SCORE : -d;
+    }
+    double best = -2.0 * PREDICTIVE_CAPTURE_SCORE;
+    for (int i = mazeGraph.offsets[cat]; i < mazeGraph.offsets[cat + 1] && !ctx.aborted; ++i) {
+        int next = mazeGraph.targets[i];
+        double value = (next == player) ? PREDICTIVE_CAPTURE_SCORE + depth : predictivePlayerNode(next, player, depth, ctx);
+        best = std::max(best, value);
+    }
+    return best;
+}
+
+// One search request and its result, so the search can run away from the game thread.
+struct PredictiveSearch {
+    int cat = -1, player = -1;
+    int budgetMs = 0;
+    uint64_t baseKey = 0; // Game-state hash with the cat and player keys removed.
+    bool found = false;
+    int step = -1;
+    int depthReached = 0;
+    long long nodes = 0, tableHits = 0;
+};
+
+/**
+ * @brief Runs one time-bounded lookahead search. Reads only the maze graph, the distance
+ * table and the transposition table, so it may run on any thread while those stay put.
+ */
+void runPredictiveSearch(PredictiveSearch& s) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(s.budgetMs);
+    int cat = s.cat, player = s.player;
+    s.step = -1;
+    s.depthReached = 0;
+    s.nodes = s.tableHits = 0;
+    s.found = true;
+    if (cat == player) return;
+    if (levelDistance(cat, player) < 0) { s.found = false; return; }
+
+    std::vector<int> moves(mazeGraph.targets.begin() + mazeGraph.offsets[cat], mazeGraph.targets.begin() + mazeGraph.offsets[cat + 1]);
+    for (int next : moves) {
+        if (s.step == -1 || levelDistance(next, player) < levelDistance(s.step, player)) s.step = next;
+    }
+    if (s.step == player) return;
+
+    std::vector<double> values(moves.size());
+    for (int depth = 1; depth <= PREDICTIVE_MAX_DEPTH; ++depth) {
+        std::atomic<size_t> nextMove(0);
+        std::atomic<bool> aborted(false);
+        std::atomic<long long> nodes(0), tableHits(0);
+        poolRun(aiPool, [&](int) {
+            PredictiveContext ctx;
+            ctx.deadline = deadline;
+            ctx.baseKey = s.baseKey;
+            for (size_t m = nextMove++; m < moves.size() && !aborted; m = nextMove++) {
+                values[m] = predictivePlayerNode(moves[m], player, depth, ctx);
+                if (ctx.aborted) aborted = true;
+            }
+            nodes += ctx.nodes;
+            tableHits += ctx.tableHits;
+        });
+        s.nodes += nodes;
+        s.tableHits += tableHits;
+        if (aborted) break;
+        size_t best = 0;
+        for (size_t m = 1; m < moves.size(); ++m) if (values[m] > values[best]) best = m;
+        s.step = moves[best];
+        s.depthReached = depth;
+        if (values[best] >= PREDICTIVE_CAPTURE_SCORE) break; // A forced capture was found.
+    }
+}
+
+/**
+ * @brief Fills in a search request for the live game. Call on the main thread.
+ */
+void preparePredictiveSearch(PredictiveSearch& s, int cat, int player, int budgetMs) {
+    ensureLevelDistances();
+    sharedAiPool();
+    if (predictiveTable.entries.empty()) ttInit(predictiveTable, PREDICTIVE_TABLE_SIZE_LOG2);
+    s = PredictiveSearch();
+    s.cat = cat;
+    s.player = player;
+    s.budgetMs = budgetMs;
+    s.baseKey = gameStateHash ^ zobristCat[catY * COLS + catX] ^ zobristPlayer[playerY * COLS + playerX];
+}
+
+/**
+ * @brief Picks the cat's next step by time-bounded lookahead search.
+ * Always returns a move: the greedy shortest-path step is used until a depth completes.
+ * @param budgetMs Wall-clock time the search may use.
+ * @param step Receives the next cell, or -1 if already at the player.
+ * @param depthReached Receives the deepest fully searched depth (0 = greedy fallback).
+ * @return True if the player is reachable.
+ */
+bool predictiveNextStep(int cat, int player, int budgetMs, int& step, int& depthReached) {
+    PredictiveSearch s;
+    preparePredictiveSearch(s, cat, player, budgetMs);
+    runPredictiveSearch(s);
+    step = s.step;
+    depthReached = s.depthReached;
+    lastSearchNodesTouched = s.nodes;
+    lastSearchTableHits = s.tableHits;
+    return s.found;
+}
+
+// In the window the search for the cat's next move runs on its own thread (fanning out
+// over the AI pool) while the cat walks its current one, so the GLUT thread never waits
+// on it. Anything that changes the layout or uses the AI pool joins it first.
+bool predictiveInBackground = false;
+std::thread predictivePlanner;
+PredictiveSearch predictivePlanned; // Owned by the planner thread until it is joined.
+
+/**
+ * @brief Waits for the background search, if one is running.
+ */
+void joinPredictiveSearch() {
+    if (predictivePlanner.joinable()) predictivePlanner.join();
+}
+
+/**
+ * @brief Waits for the background search and forgets its result, e.g. because the layout changes.
+ */
+void discardPredictiveSearch() {
+    joinPredictiveSearch();
+    predictivePlanned = PredictiveSearch();
+}
+
+/**
+ * @brief Window play: takes the move the background search planned during the last tick
+ * and starts planning the next one from the cell the cat is about to step to.
+ * @return True if the player is reachable.
+ */
+bool predictiveBackgroundStep(int cat, int player, int budgetMs, int& step) {
+    joinPredictiveSearch(); // Long done: the budget is a fraction of the cat's delay.
+    ensureLevelDistances();
+    step = -1;
+    if (cat == player) return true;
+    if (levelDistance(cat, player) < 0) return false;
+    if (predictivePlanned.cat == cat && predictivePlanned.found && predictivePlanned.step != -1) {
+        step = predictivePlanned.step;
+    } else {
+        // Nothing planned from here (first move, restored game): take the greedy step.
+        for (int i = mazeGraph.offsets[cat]; i < mazeGraph.offsets[cat + 1]; ++i) {
+            int next = mazeGraph.targets[i];
+            if (step == -1 || levelDistance(next, player) < levelDistance(step, player)) step = next;
+        }
+    }
+    // The plan saw the mouse where it stood a tick ago; never walk past a capture.
+    for (int i = mazeGraph.offsets[cat]; i < mazeGraph.offsets[cat + 1]; ++i) if (mazeGraph.targets[i] == player) step = player;
+    lastSearchNodesTouched = predictivePlanned.nodes;
+    lastSearchTableHits = predictivePlanned.tableHits;
+
+    static bool joinAtExit = false;
+    preparePredictiveSearch(predictivePlanned, step, player, budgetMs);
+    if (!joinAtExit) {
+        atexit(joinPredictiveSearch); // Registered after the pool's own handler, so it runs first.
+        joinAtExit = true;
+    }
+    if (step != player) predictivePlanner = std::thread([]() { runPredictiveSearch(predictivePlanned); });
+    return true;
+}
+
+// --- Retrograde Tablebase ---
+// For a fixed layout, every position (mouse cell, cat cell, side to move) is solved
+// offline by retrograde analysis under turn-based rules: the mouse steps or stays, then
+// the cat must step. Each entry holds the number of plies until a forced capture, or
+// TABLEBASE_ESCAPABLE if the mouse can evade forever. Files are memory-mapped at level load.
+const uint32_t TABLEBASE_MAGIC = 0x42544d43; // "CMTB"
+const uint32_t TABLEBASE_VERSION = 1;
+const uint16_t TABLEBASE_ESCAPABLE = 0xFFFF;
+const int TABLEBASE_MOUSE_TO_MOVE = 0;
+const int TABLEBASE_CAT_TO_MOVE = 1;
+
+struct TablebaseHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t pathCells;
+    uint32_t reserved;
+    uint64_t mazeHash; // Must match the maze graph the table is used with.
+};
+
+struct Tablebase {
+    std::vector<int> pathIndex;       // Grid cell -> index among path cells, or -1.
+    int pathCells = 0;
+    const uint16_t* entries = nullptr; // 2 * pathCells * pathCells entries, or null if not loaded.
+    std::vector<uint16_t> owned;       // Backing store when the file could not be mapped.
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+};
+Tablebase levelTablebase;
+int levelTablebaseLevel = 0; // Level levelTablebase was last loaded for, whether or not a file matched; 0 if none.
+
+/**
+ * @brief FNV-1a hash of the compiled adjacency, so walls and portals are both covered.
+ */
+uint64_t mazeGraphHash(const MazeGraph& graph) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](int value) { hash = (hash ^ (uint32_t)value) * 1099511628211ull; };
+    mix(graph.width);
+    mix(graph.height);
+    for (int v : graph.offsets) mix(v);
+    for (int v : graph.targets) mix(v);
+    return hash;
+}
+
+size_t tablebaseIndex(int pathCells, int turn, int mouse, int cat) {
+    return ((size_t)turn * pathCells + mouse) * pathCells + cat;
+}
+
+/**
+ * @brief Solves every position of a layout by retrograde analysis.
+ * Captured positions are seeded at distance 0 and resolved backwards layer by layer:
+ * a cat-to-move position is lost for the mouse as soon as one cat move reaches a lost
+ * position, a mouse-to-move position only once every mouse option (including staying) does.
+ * @param entries Receives 2 * pathCells^2 distances, indexed by tablebaseIndex().
+ * @return The number of path cells.
+ */
+int solveTablebase(const MazeGraph& graph, std::vector<uint16_t>& entries) {
+    int cellCount = graph.width * graph.height;
+    std::vector<int> pathIndex(cellCount, -1), pathCell;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (graph.walkable[cell]) { pathIndex[cell] = pathCell.size(); pathCell.push_back(cell); }
+    }
+    int n = pathCell.size();
+    entries.assign((size_t)2 * n * n, TABLEBASE_ESCAPABLE);
+    std::vector<uint8_t> remaining((size_t)n * n); // Unresolved options of each mouse-to-move position.
+    for (int m = 0; m < n; ++m) {
+        int options = graph.offsets[pathCell[m] + 1] - graph.offsets[pathCell[m]] + 1;
+        for (int c = 0; c < n; ++c) remaining[(size_t)m * n + c] = options;
+    }
+    std::vector<size_t> queue;
+    for (int k = 0; k < n; ++k) {
+        for (int turn = 0; turn < 2; ++turn) {
+            entries[tablebaseIndex(n, turn, k, k)] = 0;
+            queue.push_back(tablebaseIndex(n, turn, k, k));
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        size_t state = queue[head];
+        int turn = state / ((size_t)n * n);
+        int m = (state / n) % n, c = state % n;
+        uint16_t d = entries[state];
+        if (turn == TABLEBASE_CAT_TO_MOVE) {
+            // Reached by a mouse move from m or one of its neighbors (or by staying on m).
+            int mc = pathCell[m];
+            for (int i = graph.offsets[mc] - 1; i < graph.offsets[mc + 1]; ++i) {
+                int from = (i < graph.offsets[mc]) ? m : pathIndex[graph.targets[i]];
+                if (from == c) continue;
+                size_t prev = tablebaseIndex(n, TABLEBASE_MOUSE_TO_MOVE, from, c);
+                if (entries[prev] != TABLEBASE_ESCAPABLE) continue;
+                if (--remaining[(size_t)from * n + c] == 0) { entries[prev] = d + 1; queue.push_back(prev); }
+            }
+        } else {
+            // Reached by a cat move from one of c's neighbors.
+            int cc = pathCell[c];
+            for (int i = graph.offsets[cc]; i < graph.offsets[cc + 1]; ++i) {
+                int from = pathIndex[graph.targets[i]];
+                if (from == m) continue;
+                size_t prev = tablebaseIndex(n, TABLEBASE_CAT_TO_MOVE, m, from);
+                if (entries[prev] != TABLEBASE_ESCAPABLE) continue;
+                entries[prev] = d + 1;
+                queue.push_back(prev);
+            }
+        }
+    }
+    return n;
+}
+
+bool writeTablebase(const std::string& path, const MazeGraph& graph, int pathCells, const std::vector<uint16_t>& entries) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    TablebaseHeader header = {TABLEBASE_MAGIC, TABLEBASE_VERSION, (uint32_t)graph.width, (uint32_t)graph.height, (uint32_t)pathCells, 0, mazeGraphHash(graph)};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(uint16_t));
+    return (bool)out;
+}
+
+void unloadTablebase(Tablebase& tb) {
+#ifndef _WIN32
+    if (tb.mapping != nullptr) munmap(tb.mapping, tb.mappingSize);
+#endif
+    tb.mapping = nullptr;
+    tb.mappingSize = 0;
+    tb.entries = nullptr;
+    tb.owned.clear();
+}
+
+/**
+ * @brief Maps a tablebase file for the given maze graph (read into memory on Windows).
+ * @return False if the file is missing, malformed, or was solved for a different layout.
+ */
+bool loadTablebase(Tablebase& tb, const std::string& path, const MazeGraph& graph) {
+    unloadTablebase(tb);
+    int cellCount = graph.width * graph.height;
+    tb.pathIndex.assign(cellCount, -1);
+    tb.pathCells = 0;
+    for (int cell = 0; cell < cellCount; ++cell) if (graph.walkable[cell]) tb.pathIndex[cell] = tb.pathCells++;
+    size_t expectedSize = sizeof(TablebaseHeader) + (size_t)2 * tb.pathCells * tb.pathCells * sizeof(uint16_t);
+    const char* data = nullptr;
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size == expectedSize) {
+        void* mapping = mmap(nullptr, expectedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) { tb.mapping = mapping; tb.mappingSize = expectedSize; data = (const char*)mapping; }
+    }
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> buffer(expectedSize);
+    if (in.read(buffer.data(), expectedSize) && in.peek() == EOF) {
+        tb.owned.resize((expectedSize - sizeof(TablebaseHeader)) / sizeof(uint16_t));
+        memcpy(tb.owned.data(), buffer.data() + sizeof(TablebaseHeader), tb.owned.size() * sizeof(uint16_t));
+        data = buffer.data();
+    }
+#endif
+    if (data == nullptr) return false;
+    TablebaseHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TABLEBASE_MAGIC || header.version != TABLEBASE_VERSION || (int)header.pathCells != tb.pathCells || header.mazeHash != mazeGraphHash(graph)) {
+        unloadTablebase(tb);
+        return false;
+    }
+    tb.entries = tb.owned.empty() ? reinterpret_cast<const uint16_t*>(data + sizeof(TablebaseHeader)) : tb.owned.data();
+    return true;
+}
+
+/**
+ * @brief Plies until a forced capture, or TABLEBASE_ESCAPABLE. O(1).
+ */
+uint16_t tablebaseLookup(const Tablebase& tb, int mouseCell, int catCell, int turn) {
+    return tb.entries[tablebaseIndex(tb.pathCells, turn, tb.pathIndex[mouseCell], tb.pathIndex[catCell])];
+}
+
+/**
+ * @brief Perfect play from the tablebase: the cat move with the fastest forced capture.
+ * @return False if no table is loaded or the mouse can escape from every cat move.
+ */
+bool tablebaseNextStep(int cat, int player, int& step) {
+    step = -1;
+    if (levelTablebase.entries == nullptr || levelTablebaseLevel != loadedMazeLevel) return false;
+    uint16_t best = TABLEBASE_ESCAPABLE;
+    for (int i = mazeGraph.offsets[cat]; i < mazeGraph.offsets[cat + 1]; ++i) {
+        int next = mazeGraph.targets[i];
+        uint16_t value = tablebaseLookup(levelTablebase, player, next, TABLEBASE_MOUSE_TO_MOVE);
+        if (value < best) { best = value; step = next; }
+    }
+    return step != -1;
+}
+
+std::string tablebasePath(const std::string& directory, int level) {
+    return directory + "/tablebase_level" + std::to_string(level) + ".cmtb";
+}
+
+/**
+ * @brief Maps the tablebase for a level from the working directory, if one was solved.
+ */
+void loadLevelTablebase(int level) {
+    bool loaded = loadTablebase(levelTablebase, tablebasePath(".", level), mazeGraph);
+    levelTablebaseLevel = level;
+    if (engineLog) std::cout << (loaded ? "Tablebase loaded for level " : "No matching tablebase for level ") << level << ".\n";
+}
+
+// --- Line-of-Sight Bitsets ---
+// Chasers see along straight rows and columns until a wall. At level load every path cell
+// gets a bitset of the cells it can see, so a vision test is a single AND.
+const int VISION_WORDS = (ROWS * COLS + 63) / 64;
+const int HEARING_DISTANCE = 3; // Chasers also notice the mouse this many steps away, around corners.
+struct VisionSet {
+    uint64_t bits[VISION_WORDS];
+};
+std::vector<VisionSet> levelVision;
+
+/**
+ * @brief Builds the visibility bitset of every path cell from the current maze.
+ */
+void buildLevelVision() {
+    levelVision.assign(ROWS * COLS, VisionSet());
+    for (int cell = 0; cell < ROWS * COLS; ++cell) {
+        if (!mazeGraph.walkable[cell]) continue;
+        VisionSet& vision = levelVision[cell];
+        int x = cell % COLS, y = cell / COLS;
+        for (int dir = 0; dir < 4; ++dir) {
+            for (int cx = x, cy = y; cx >= 0 && cx < COLS && cy >= 0 && cy < ROWS && mazeGraph.walkable[cy * COLS + cx]; cx += DIR_DX[dir], cy += DIR_DY[dir]) {
+                int seen = cy * COLS + cx;
+                vision.bits[seen >> 6] |= (uint64_t)1 << (seen & 63);
+            }
+        }
+    }
+}
+
+bool canSee(int from, int to) {
+    return (levelVision[from].bits[to >> 6] & ((uint64_t)1 << (to & 63))) != 0;
+}
+
+// --- Chokepoint Analysis ---
+// Tarjan's algorithm finds the articulation points and bridges of the path graph in one
+// DFS per connected component. Each DFS is rooted in the largest part of its component
+// (the core), so every articulation point guards a pocket of cells hanging off it. For
+// each cell the innermost guarding point is stored; following it repeatedly walks
+// outwards to the core.
+std::vector<int> levelPocketGate;  // Innermost articulation point cutting a cell off from the core, or -1.
+std::vector<int> levelPocketSize;  // Cells in the pocket behind that gate (0 in the core).
+std::vector<std::pair<int, int>> levelBridges;
+int levelArticulationCount = 0;
+
+/**
+ * @brief One iterative Tarjan DFS from root over the walkable cells of its component.
+ * Every cell of the component must have disc -1, parent -1 and subtreeSize 1 beforehand.
+ * @param parent Receives the DFS tree parent (root is its own parent, -1 = unreached).
+ * @param order Receives the component's cells in preorder.
+ */
+void tarjanDfs(const MazeGraph& graph, int root, std::vector<int>& disc, std::vector<int>& low, std::vector<int>& parent,
+               std::vector<int>& subtreeSize, std::vector<int>& order) {
+    order.clear();
+    std::vector<std::pair<int, int>> stack; // (cell, next edge index)
+    disc[root] = low[root] = 0;
+    parent[root] = root;
+    order.push_back(root);
+    stack.push_back({root, graph.offsets[root]});
+    while (!stack.empty()) {
+        int cell = stack.back().first;
+        int& edge = stack.back().second;
+        if (edge < graph.offsets[cell + 1]) {
+            int next = graph.targets[edge++];
+            if (disc[next] == -1) {
+                disc[next] = low[next] = (int)order.size();
+                parent[next] = cell;
+                order.push_back(next);
+                stack.push_back({next, graph.offsets[next]});
+            } else if (next != parent[cell]) {
+                low[cell] = std::min(low[cell], disc[next]);
+            }
+        } else {
+            stack.pop_back();
+            if (cell != root) {
+                int up = parent[cell];
+                low[up] = std::min(low[up], low[cell]);
+                subtreeSize[up] += subtreeSize[cell];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds articulation points, bridges and the pocket behind each articulation point,
+ * in every connected component of the maze.
+ */
+void buildLevelChokepoints() {
+    int cellCount = ROWS * COLS;
+    levelPocketGate.assign(cellCount, -1);
+    levelPocketSize.assign(cellCount, 0);
+    levelBridges.clear();
+    levelArticulationCount = 0;
+    std::vector<int> disc(cellCount, -1), low(cellCount, 0), parent(cellCount, -1), subtreeSize(cellCount, 1), order;
+    std::vector<bool> isArticulation(cellCount, false);
+    for (int start = 0; start < cellCount; ++start) {
+        if (!mazeGraph.walkable[start] || disc[start] != -1) continue;
+
+        // The root is a cut vertex only with several DFS children; its biggest child stays in the core.
+        int root = start, rootChildren = 0, coreChild = -1;
+        auto separates = [&](int cell) {
+            int up = parent[cell];
+            if (up == root) return rootChildren > 1 && cell != coreChild;
+            return low[cell] >= disc[up];
+        };
+        // Re-root until no single cut leaves more than half of the component below it.
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            for (int cell : order) { disc[cell] = -1; parent[cell] = -1; subtreeSize[cell] = 1; }
+            tarjanDfs(mazeGraph, root, disc, low, parent, subtreeSize, order);
+            rootChildren = 0;
+            coreChild = -1;
+            for (int cell : order) {
+                if (cell == root || parent[cell] != root) continue;
+                rootChildren++;
+                if (coreChild == -1 || subtreeSize[cell] > subtreeSize[coreChild]) coreChild = cell;
+            }
+            int heavy = -1;
+            for (int cell : order) {
+                if (cell != root && separates(cell) && 2 * subtreeSize[cell] > (int)order.size()) {
+                    if (heavy == -1 || subtreeSize[cell] < subtreeSize[heavy]) heavy = cell;
+                }
+            }
+            if (heavy == -1) break;
+            root = heavy;
+        }
+
+        // Preorder guarantees a cell's parent is labeled before the cell itself.
+        for (int cell : order) {
+            if (cell == root) continue;
+            int up = parent[cell];
+            if (low[cell] > disc[up]) levelBridges.push_back({up, cell});
+            if (separates(cell)) {
+                isArticulation[up] = true;
+                levelPocketGate[cell] = up;
+                levelPocketSize[cell] = subtreeSize[cell];
+            } else {
+                levelPocketGate[cell] = levelPocketGate[up];
+                levelPocketSize[cell] = levelPocketSize[up];
+            }
+        }
+        order.clear(); // The component keeps its labels; the next one starts fresh.
+    }
+    for (int cell = 0; cell < cellCount; ++cell) levelArticulationCount += isArticulation[cell];
+}
+
+// --- Item Placement Optimizer ---
+// Instead of taking the first random placement, the workers draw a fixed number of random
+// candidates and score each one with lookups in the level's distance tables: cheese should
+// be spread out, not next to the cat's start, reachable, and not buried deep in dead-end
+// pockets where the cat can corner the mouse. The best candidate wins. The candidates come
+// from PLACEMENT_STREAMS seeds taken off the game RNG, so the winner depends only on the
+// game's seed and not on the core count or the clock; versus peers place the same items.
+// The work is bounded by the candidate count alone, never by a deadline.
+const int PLACEMENT_CANDIDATES = 8192;
+const int PLACEMENT_STREAMS = 16;    // Shared out among however many workers there are.
+const int PLACEMENT_CAT_SAFE_DISTANCE = 6;   // Cheese farther than this from the cat start earns no more.
+const int PLACEMENT_POWERUP_MIN_CAT_DISTANCE = 4;
+const float PLACEMENT_SPREAD_WEIGHT = 1.0f;
+const float PLACEMENT_CAT_WEIGHT = 0.5f;
+const float PLACEMENT_EXPOSURE_WEIGHT = 0.75f;
+int lastPlacementCandidates = 0;
+float lastPlacementScore = 0.0f;
+
+struct ItemPlacement {
+    int cheese[NUM_CHEESE_TO_PLACE];
+    int powerups[NUM_POWERUPS_PER_LEVEL];
+    float score = -1e30f;
+};
+
+/**
+ * @brief Draws a random placement with the rules of initLevelData(). Returns false if the
+ * maze is too small to hold every item.
+ */
+bool randomPlacement(ItemPlacement& placement, std::mt19937& rng) {
+    int player = PLAYER_START_Y * COLS + PLAYER_START_X, cat = CAT_START_Y * COLS + CAT_START_X;
+    int placed = 0;
+    const int total = NUM_CHEESE_TO_PLACE + NUM_POWERUPS_PER_LEVEL;
+    int items[total];
+    for (int attempts = 0; placed < total && attempts < ROWS * COLS * 10; ++attempts) {
+        int cell = rng() % (ROWS * COLS);
+        if (maze[cell / COLS][cell % COLS] != TILE_PATH || cell == player || cell == cat) continue;
+        bool taken = false;
+        for (int i = 0; i < placed; ++i) taken = taken || items[i] == cell;
+        if (!taken) items[placed++] = cell;
+    }
+    if (placed < total) return false;
+    std::copy(items, items + NUM_CHEESE_TO_PLACE, placement.cheese);
+    std::copy(items + NUM_CHEESE_TO_PLACE, items + total, placement.powerups);
+    return true;
+}
+
+/**
+ * @brief Higher is better; unreachable items make a placement unusable.
+ */
+float scorePlacement(const ItemPlacement& placement) {
+    int player = PLAYER_START_Y * COLS + PLAYER_START_X, cat = CAT_START_Y * COLS + CAT_START_X;
+    float nearestSum = 0.0f, catSum = 0.0f, exposureSum = 0.0f;
+    int nearestMin = INT_MAX;
+    for (int i = 0; i < NUM_CHEESE_TO_PLACE; ++i) {
+        int cell = placement.cheese[i];
+        if (levelDistance(player, cell) < 0) return -1e30f;
+        int nearest = INT_MAX;
+        for (int j = 0; j < NUM_CHEESE_TO_PLACE; ++j) if (j != i) nearest = std::min(nearest, levelDistance(cell, placement.cheese[j]));
+        nearestSum += nearest;
+        nearestMin = std::min(nearestMin, nearest);
+        catSum += std::min(levelDistance(cat, cell), PLACEMENT_CAT_SAFE_DISTANCE);
+        if (levelPocketGate[cell] != -1) exposureSum += levelDistance(cell, levelPocketGate[cell]); // Steps into a dead end.
+    }
+    for (int i = 0; i < NUM_POWERUPS_PER_LEVEL; ++i) {
+        int cell = placement.powerups[i];
+        if (levelDistance(player, cell) < 0) return -1e30f;
+        if (levelDistance(cat, cell) < PLACEMENT_POWERUP_MIN_CAT_DISTANCE) catSum -= PLACEMENT_CAT_SAFE_DISTANCE;
+    }
+    float spread = nearestSum / NUM_CHEESE_TO_PLACE + 0.5f * nearestMin;
+    return PLACEMENT_SPREAD_WEIGHT * spread + PLACEMENT_CAT_WEIGHT * catSum / NUM_CHEESE_TO_PLACE
+         - PLACEMENT_EXPOSURE_WEIGHT * exposureSum / NUM_CHEESE_TO_PLACE;
+}
+
+/**
+ * @brief Fills cheeseLocations and powerupLocations with the best of PLACEMENT_CANDIDATES
+ * placements. Leaves them empty if no valid placement exists.
+ */
+void placeItemsOptimized() {
+    ensureLevelDistances(); // Scored on the workers, which must not build it.
+    joinPredictiveSearch(); // The pool runs one job at a time.
+    WorkerPool& pool = sharedAiPool();
+    std::vector<ItemPlacement> bests(PLACEMENT_STREAMS);
+    std::vector<int> counts(PLACEMENT_STREAMS, 0);
+    std::vector<unsigned> seeds;
+    for (int i = 0; i < PLACEMENT_STREAMS; ++i) seeds.push_back(gameRandom()); // The game RNG is not thread-safe.
+    int workers = poolSize(pool);
+    poolRun(pool, [&](int worker) {
+        ItemPlacement candidate;
+        for (int stream = worker; stream < PLACEMENT_STREAMS; stream += workers) {
+            std::mt19937 rng(seeds[stream]);
+            for (int i = 0; i < PLACEMENT_CANDIDATES / PLACEMENT_STREAMS; ++i) {
+                if (!randomPlacement(candidate, rng)) break; // Ends this stream only, whichever worker runs it.
+                candidate.score = scorePlacement(candidate);
+                if (candidate.score > bests[stream].score) bests[stream] = candidate;
+                counts[stream]++;
+            }
+        }
+    });
+    const ItemPlacement* best = &bests[0]; // Ties go to the lowest stream, whichever worker ran it.
+    lastPlacementCandidates = 0;
+    for (size_t i = 0; i < bests.size(); ++i) {
+        lastPlacementCandidates += counts[i];
+        if (bests[i].score > best->score) best = &bests[i];
+    }
+    lastPlacementScore = best->score;
+    if (best->score <= -1e30f) return;
+    for (int cell : best->cheese) cheeseLocations.push_back({cell % COLS, cell / COLS});
+    for (int cell : best->powerups) powerupLocations.push_back({cell % COLS, cell / COLS, TILE_SLOW_POWERUP});
+}
+
+// --- Ambush Personalities ---
+// Once per tick, a single multi-source BFS from every chaser (main cat first) gives each
+// cell its distance to the nearest chaser and which chaser that is. Each personality picks
+// its target from this shared field and steps along the level distance table, so every
+// extra chaser costs a few lookups rather than another search.
+const int INTERCEPT_LOOKAHEAD = 4;   // How many cells ahead of the player the interceptor aims.
+const int FLANK_ENGAGE_DISTANCE = 2; // Flankers go straight for the player once this close.
+const int PATROL_ALERT_DISTANCE = 5; // Patrollers break off their round within this range.
+std::vector<int> chaserField;        // Distance to the nearest chaser, per cell.
+std::vector<int> chaserOwner;        // Nearest chaser per cell: 0 = main cat, i + 1 = ambushers[i].
+int lastChaserFieldExpanded = 0;
+
+/**
+ * @brief Recomputes the shared chaser field from the current chaser positions.
+ */
+void updateChaserField() {
+    static std::vector<int> sources;
+    sources.clear();
+    sources.push_back(catY * COLS + catX);
+    for (const auto& a : ambushers) sources.push_back(a.y * COLS + a.x);
+    lastChaserFieldExpanded = bfsDistanceField(mazeGraph, sources, chaserField, -1, &chaserOwner);
+}
+
+/**
+ * @brief Follows the player's heading (turning at corners, never reversing) for up to
+ * INTERCEPT_LOOKAHEAD cells, stopping early at the first cell this chaser reaches in time.
+ */
+int interceptTarget(int self) {
+    int cell = playerY * COLS + playerX;
+    int heading = playerHeading;
+    for (int ahead = 1; ahead <= INTERCEPT_LOOKAHEAD; ++ahead) {
+        int next = mazeGraph.moves[cell * 4 + heading];
+        for (int dir = 0; dir < 4 && next == cell; ++dir) {
+            if (dir == heading || dir == DIR_OPPOSITE[heading]) continue;
+            if (mazeGraph.moves[cell * 4 + dir] != cell) {
+                heading = dir;
+                next = mazeGraph.moves[cell * 4 + dir];
+            }
+        }
+        if (next == cell) break; // Dead end: the player has to come back this way.
+        cell = next;
+        if (chaserOwner[cell] == self && chaserField[cell] <= ahead) break;
+    }
+    return cell;
+}
+
+/**
+ * @brief Covers the player's least guarded neighbor, cutting off the escape the other
+ * chasers leave open; closes in directly when already near.
+ */
+int flankTarget(int cell) {
+    int player = playerY * COLS + playerX;
+    if (levelDistance(cell, player) <= FLANK_ENGAGE_DISTANCE) return player;
+    int best = player;
+    for (int i = mazeGraph.offsets[player]; i < mazeGraph.offsets[player + 1]; ++i) {
+        int next = mazeGraph.targets[i];
+        if (best == player || chaserField[next] > chaserField[best]) best = next;
+    }
+    return best;
+}
+
+/**
+ * @brief Tours the cheese, always heading for the one farthest from every chaser, and
+ * chases the player when they come close.
+ */
+int patrolTarget(Ambusher& a, int cell) {
+    int player = playerY * COLS + playerX;
+    if (levelDistance(cell, player) <= PATROL_ALERT_DISTANCE || cheeseLocations.empty()) return player;
+    bool goalValid = false;
+    for (const auto& loc : cheeseLocations) goalValid = goalValid || (loc.y * COLS + loc.x == a.goal);
+    if (!goalValid || a.goal == cell) {
+        a.goal = -1;
+        for (const auto& loc : cheeseLocations) {
+            int c = loc.y * COLS + loc.x;
+            if (c != cell && (a.goal == -1 || chaserField[c] > chaserField[a.goal])) a.goal = c;
+        }
+        if (a.goal == -1) return player;
+    }
+    return a.goal;
+}
+
+/**
+ * @brief Pursues while the mouse is seen or heard, then checks where it was last noticed,
+ * then wanders between random junctions until it turns up again.
+ */
+int watchTarget(Ambusher& a, int cell) {
+    int player = playerY * COLS + playerX;
+    if (canSee(cell, player) || levelDistance(cell, player) <= HEARING_DISTANCE) {
+        a.goal = player;
+        return player;
+    }
+    if (a.goal == -1 || a.goal == cell) {
+        const std::vector<int>& junctions = levelJunctions.nodeCells;
+        a.goal = junctions.empty() ? cell : junctions[gameRandom() % junctions.size()];
+    }
+    return a.goal;
+}
+
+/**
+ * @brief The neighbor of a cell closest to the target, or the cell itself if none is closer.
+ */
+int ambushStep(int cell, int target) {
+    int best = cell;
+    int bestDist = levelDistance(cell, target);
+    for (int i = mazeGraph.offsets[cell]; i < mazeGraph.offsets[cell + 1]; ++i) {
+        int next = mazeGraph.targets[i];
+        int d = levelDistance(next, target);
+        if (d >= 0 && (bestDist < 0 || d < bestDist)) { best = next; bestDist = d; }
+    }
+    return best;
+}
+
+/**
+ * @brief Moves every ambusher one step according to its personality, using the chaser
+ * field as refreshed after the main cat's step.
+ */
+void moveAmbushers() {
+    if (!ambushers.empty()) ensureLevelDistances();
+    for (int i = 0; i < ambushers.size(); ++i) {
+        Ambusher& a = ambushers[i];
+        int cell = a.y * COLS + a.x;
+        int target = cell;
+        switch (a.personality) {
+            case PERSONALITY_INTERCEPTOR: target = interceptTarget((int)i + 1); break;
+            case PERSONALITY_FLANKER: target = flankTarget(cell); break;
+            case PERSONALITY_PATROLLER: target = patrolTarget(a, cell); break;
+            case PERSONALITY_WATCHER: target = watchTarget(a, cell); break;
+            case PERSONALITY_COUNT: break;
+        }
+        int next = ambushStep(cell, target);
+        if (next != cell) {
+            gameStateHash ^= zobristAmbusher[i][cell] ^ zobristAmbusher[i][next];
+            a.x = next % COLS;
+            a.y = next / COLS;
+        }
+    }
+}
+
+// --- Danger Map and Safe-Route Hint ---
+// The chaser field doubles as a danger map. The hint is the route to cheese whose closest
+// approach to any chaser is as far as possible (a bottleneck path), and the shortest such
+// route. Phase one settles cells in decreasing bottleneck order using buckets, stopping at
+// the first cheese; phase two is a BFS restricted to cells at least that safe.
+int safeRouteBottleneck = -1;        // Closest approach to a chaser along the route.
+std::vector<int> safeRouteWidest;    // Scratch buffers, reused between updates.
+std::vector<int> safeRouteParent;
+std::vector<int> safeRouteQueue;
+std::vector<std::vector<int>> safeRouteBuckets;
+std::vector<bool> safeRouteIsGoal;
+
+/**
+ * @brief Finds the safest route from a cell to the nearest of a set of goal cells.
+ * Routes with the same bottleneck are ranked by length, so ties go to the cheese that
+ * is nearest by path among those reachable at that safety.
+ * @param field Distance to the nearest chaser per cell (-1 if no chaser can reach it).
+ * @param route Receives the route excluding the start cell; empty if no goal is reachable.
+ * @return The route's bottleneck: the smallest field value along it, or -1 if none.
+ */
+int safestRoute(const MazeGraph& graph, const std::vector<int>& field, int start, const std::vector<int>& goals, std::vector<int>& route) {
+    int cellCount = graph.width * graph.height;
+    route.clear();
+    if (goals.empty()) return -1;
+    int unreached = *std::max_element(field.begin(), field.end()) + 1; // Safer than any reachable cell.
+    auto safety = [&](int c) { return field[c] < 0 ? unreached : field[c]; };
+    safeRouteIsGoal.assign(cellCount, false);
+    for (int c : goals) safeRouteIsGoal[c] = true;
+
+    // Phase one: the best achievable bottleneck, settled from the safest cells down.
+    safeRouteWidest.assign(cellCount, -1);
+    if ((int)safeRouteBuckets.size() < unreached + 2) safeRouteBuckets.resize(unreached + 2);
+    for (int level = 0; level <= unreached + 1; ++level) safeRouteBuckets[level].clear();
+    safeRouteWidest[start] = unreached + 1; // The start cell itself does not count.
+    safeRouteBuckets[unreached + 1].push_back(start);
+    int bottleneck = -1;
+    for (int level = unreached + 1; level >= 0 && bottleneck == -1; --level) {
+        auto& bucket = safeRouteBuckets[level];
+        for (size_t k = 0; k < bucket.size(); ++k) {
+            int cell = bucket[k];
+            if (safeRouteWidest[cell] != level) continue; // Stale entry.
+            if (cell != start && safeRouteIsGoal[cell]) { bottleneck = level; break; }
+            for (int i = graph.offsets[cell]; i < graph.offsets[cell + 1]; ++i) {
+                int next = graph.targets[i];
+                int width = std::min(level, safety(next));
+                if (width > safeRouteWidest[next]) {
+                    safeRouteWidest[next] = width;
+                    safeRouteBuckets[width].push_back(next);
+                }
+            }
+        }
+    }
+    if (bottleneck == -1) return -1;
+
+    // Phase two: the shortest route that never gets closer than the bottleneck.
+    safeRouteParent.assign(cellCount, -1);
+    safeRouteQueue.clear();
+    safeRouteQueue.push_back(start);
+    safeRouteParent[start] = start;
+    for (size_t head = 0; head < safeRouteQueue.size(); ++head) {
+        int cell = safeRouteQueue[head];
+        if (cell != start && safeRouteIsGoal[cell]) {
+            for (int c = cell; c != start; c = safeRouteParent[c]) route.push_back(c);
+            std::reverse(route.begin(), route.end());
+            break;
+        }
+        for (int i = graph.offsets[cell]; i < graph.offsets[cell + 1]; ++i) {
+            int next = graph.targets[i];
+            if (safeRouteParent[next] == -1 && safety(next) >= bottleneck) {
+                safeRouteParent[next] = cell;
+                safeRouteQueue.push_back(next);
+            }
+        }
+    }
+    return bottleneck;
+}
+
+/**
+ * @brief Refreshes the hint after the player or any chaser moves. Does nothing while hidden.
+ */
+void updateSafeRoute() {
+    if (!showSafeRouteHint) return;
+    static std::vector<int> goals;
+    goals.clear();
+    for (const auto& loc : cheeseLocations) goals.push_back(loc.y * COLS + loc.x);
+    safeRouteBottleneck = safestRoute(mazeGraph, chaserField, playerY * COLS + playerX, goals, safeRoute);
+}
+
+// --- Level Pathfinding Data ---
+HpaGraph levelHpa;
+HpaChaser catHpaChaser;
+DStarPlanner catDStar;
+
+/**
+ * @brief Builds every pathfinding structure for the freshly compiled maze graph.
+ */
+void buildLevelPathfinding() {
+    discardPredictiveSearch();
+    buildJunctionGraph(levelJunctions, mazeGraph);
+    hpaBuild(levelHpa, mazeGraph, HPA_SECTOR_SIZE);
+    resetLevelDistances();
+    buildLevelVision();
+    buildLevelChokepoints();
+    ttClear(predictiveTable);
+    catHpaChaser = HpaChaser();
+    catDStar = DStarPlanner(); // Initialized lazily on the cat's first move.
+}
+
+/**
+ * @brief Changes a single tile at runtime (e.g. opening or closing a door) and
+ * refreshes the pathfinding data. The maze graph, junction graph and sector abstraction
+ * are patched around the tile; the level-wide tables are rebuilt.
+ */
+void setTile(int x, int y, int tile) {
+    if (maze[y][x] == tile) return;
+    discardPredictiveSearch();
+    maze[y][x] = tile;
+    loadedMazeLevel = 0; // No longer the stock layout of any level.
+    int cell = y * COLS + x;
+    // Every cell whose adjacency may have changed: the tile, its grid neighbors and portal partners.
+    std::vector<int> changed = {cell};
+    patchMazeGraph(mazeGraph, &maze[0][0], levelPortals, changed);
+    patchJunctionGraph(levelJunctions, changed);
+    resetLevelDistances();
+    buildLevelVision();
+    buildLevelChokepoints();
+    ttClear(predictiveTable); // Cached search values assume the old distances.
+    unloadTablebase(levelTablebase); // Solved for the old layout.
+    levelTablebaseLevel = 0;
+    hpaUpdateCell(levelHpa, cell);
+    dstarNotifyChanged(catDStar, changed);
+    updateChaserField();
+    updateSafeRoute();
+}
+
+/**
+ * @brief Copies the live game state into a snapshot: one memcpy of the state block.
+ */
+void snapshotGame(GameSnapshot& out) {
+    std::memcpy(&out, &liveGame, sizeof(GameSnapshot));
+}
+
+/**
+ * @brief Restores a snapshot taken with snapshotGame. The maze is only reloaded when the
+ * snapshot is on another level; otherwise just the per-move caches derived from positions
+ * are refreshed, so restoring within a level costs little more than the copy.
+ */
+void restoreGame(const GameSnapshot& in) {
+    std::memcpy(&liveGame, &in, sizeof(GameSnapshot));
+    loadLevelMaze(currentLevel);
+    if (!ambushers.empty() || showSafeRouteHint) {
+        updateChaserField(); // Only the ambushers and the route hint read the danger map.
+        updateSafeRoute();
+    }
+}
+
+/**
+ * @brief Loads a level's layout unless it is already the loaded maze, in which case only
+ * the caches tied to a single chase are reset. The level's tablebase is loaded too if the
+ * cat was switched to it after the maze was.
+ */
+void loadLevelMaze(int level) {
+    if (loadedMazeLevel != level) {
+        initMaze(level);
+    } else {
+        catHpaChaser = HpaChaser();
+        catDStar = DStarPlanner();
+    }
+    if (catPathfinder == PATHFINDER_TABLEBASE && levelTablebaseLevel != level) loadLevelTablebase(level);
+}
+
+// --- Replays ---
+// A replay file is the stream of state-changing events (4 bytes each) interleaved with
+// keyframes: a marker event followed by the raw GameSnapshot from just before the next
+// event. Keyframes are written every REPLAY_KEYFRAME_INTERVAL events and after every level
+// start, so seeking never re-simulates a level load. An index of (tick, offset) pairs and
+// a footer close the file; if a session ended without one, the stream is scanned instead.
+// A tick is one event. Cat moves store the direction the cat actually took, so playback
+// never reruns the pathfinder: the predictive cat's search depends on its time budget and,
+// in the game, runs a tick ahead on a worker, and neither can be repeated exactly.
+const uint32_t REPLAY_MAGIC = 0x50524d43; // "CMRP"
+const uint32_t REPLAY_VERSION = 2;
+const uint8_t REPLAY_CAT_STAY = 4; // REPLAY_CAT_MOVE argument when the cat found no step.
+const int REPLAY_KEYFRAME_INTERVAL = 256;
+
+struct ReplayEvent {
+    uint8_t type;
+    uint8_t arg;    // Direction (or REPLAY_CAT_STAY), level or pause flag.
+    uint16_t value; // Milliseconds for REPLAY_SLOW_TIMER.
+};
+
+struct ReplayHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t keyframeInterval;
+    uint32_t snapshotSize; // sizeof(GameSnapshot) of the writer; files from other builds are rejected.
+    uint32_t pathfinder;
+    uint32_t reserved;
+    CatSpeedCurve speedCurves[MAX_LEVELS + 1]; // The cat speeds the session was played with.
+};
+
+struct ReplayIndexEntry {
+    uint64_t tick;   // Events applied before the keyframe.
+    uint64_t offset; // File offset of the keyframe marker.
+};
+
+struct ReplayFooter {
+    uint64_t indexOffset;
+    uint64_t tickCount;
+    uint32_t keyframeCount;
+    uint32_t magic;
+};
+
+struct ReplayWriter {
+    std::ofstream out;
+    uint64_t offset = 0;
+    uint64_t ticks = 0;
+    uint64_t lastKeyframe = 0;
+    bool keyframeDue = true;
+    std::vector<ReplayIndexEntry> index;
+};
+ReplayWriter liveRecording; // Opened by --record=<file>.
+
+struct ReplayReader {
+    const char* data = nullptr;
+    size_t size = 0;
+    ReplayHeader header;
+    std::vector<ReplayIndexEntry> index;
+    uint64_t tickCount = 0;
+    std::vector<char> owned; // Backing store when the file could not be mapped.
+    void* mapping = nullptr;
+};
+
+bool replayBeginRecording(ReplayWriter& w, const std::string& path) {
+    w.out.open(path, std::ios::binary);
+    if (!w.out) return false;
+    ReplayHeader header = {REPLAY_MAGIC, REPLAY_VERSION, REPLAY_KEYFRAME_INTERVAL, (uint32_t)sizeof(GameSnapshot), (uint32_t)catPathfinder, 0, {}};
+    std::copy(levelSpeedCurves, levelSpeedCurves + MAX_LEVELS + 1, header.speedCurves);
+    w.out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    w.offset = sizeof(header);
+    w.ticks = w.lastKeyframe = 0;
+    w.keyframeDue = true;
+    w.index.clear();
+    return (bool)w.out;
+}
+
+void replayWriteKeyframe(ReplayWriter& w) {
+    ReplayEvent marker = {REPLAY_KEYFRAME, 0, 0};
+    w.index.push_back({w.ticks, w.offset});
+    w.out.write(reinterpret_cast<const char*>(&marker), sizeof(marker));
+    w.out.write(reinterpret_cast<const char*>(&liveGame), sizeof(GameSnapshot));
+    w.offset += sizeof(marker) + sizeof(GameSnapshot);
+    w.lastKeyframe = w.ticks;
+    w.keyframeDue = false;
+}
+
+/**
+ * @brief Appends an event that is about to be applied to the live game, preceded by a
+ * keyframe of the current state when one is due.
+ */
+void replayAppend(ReplayWriter& w, const ReplayEvent& event) {
+    if (w.keyframeDue || w.ticks - w.lastKeyframe >= REPLAY_KEYFRAME_INTERVAL) replayWriteKeyframe(w);
+    w.out.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    w.offset += sizeof(event);
+    w.ticks++;
+    if (event.type == REPLAY_NEW_GAME || event.type == REPLAY_START_LEVEL) w.keyframeDue = true;
+}
+
+/**
+ * @brief Writes the final keyframe (if one is due), the index and the footer.
+ */
+void replayFinishRecording(ReplayWriter& w) {
+    if (!w.out.is_open()) return;
+    if (w.keyframeDue) replayWriteKeyframe(w);
+    ReplayFooter footer = {w.offset, w.ticks, (uint32_t)w.index.size(), REPLAY_MAGIC};
+    w.out.write(reinterpret_cast<const char*>(w.index.data()), w.index.size() * sizeof(ReplayIndexEntry));
+    w.out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    w.out.close();
+}
+
+void recordReplayEvent(uint8_t type, uint8_t arg, uint16_t value) {
+    if (liveRecording.out.is_open()) replayAppend(liveRecording, {type, arg, value});
+}
+
+/**
+ * @brief Applies one recorded event to the live game, exactly as the game applied it.
+ */
+void applyReplayEvent(const ReplayEvent& event) {
+    switch (event.type) {
+        case REPLAY_NEW_GAME: totalScore = 0; startLevel(1); break;
+        case REPLAY_START_LEVEL: startLevel(event.arg); break;
+        case REPLAY_PLAYER_MOVE: applyPlayerMove((Direction)event.arg); break;
+        case REPLAY_CAT_MOVE: {
+            int cell = catY * COLS + catX;
+            moveCatTo(event.arg == REPLAY_CAT_STAY ? -1 : mazeGraph.moves[cell * 4 + event.arg]);
+            break;
+        }
+        case REPLAY_SLOW_TIMER: advanceSlowdownTimer(event.value); break;
+        case REPLAY_PAUSE: currentGameState = event.arg ? PAUSED : PLAYING; break;
+    }
+}
+
+void closeReplay(ReplayReader& r) {
+#ifndef _WIN32
+    if (r.mapping != nullptr) munmap(r.mapping, r.size);
+#endif
+    r.mapping = nullptr;
+    r.data = nullptr;
+    r.size = 0;
+    r.index.clear();
+    r.owned.clear();
+}
+
+/**
+ * @brief Maps a replay file (read into memory on Windows) and loads its keyframe index,
+ * rebuilding the index by a scan when the recording was cut off before the footer.
+ * @return False if the file is missing or was written by an incompatible build.
+ */
+bool openReplay(ReplayReader& r, const std::string& path) {
+    closeReplay(r);
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(ReplayHeader)) {
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) { r.mapping = mapping; r.size = info.st_size; r.data = (const char*)mapping; }
+    }
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    r.owned.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (r.owned.size() >= sizeof(ReplayHeader)) { r.data = r.owned.data(); r.size = r.owned.size(); }
+#endif
+    if (r.data == nullptr) return false;
+    memcpy(&r.header, r.data, sizeof(r.header));
+    if (r.header.magic != REPLAY_MAGIC || r.header.version != REPLAY_VERSION || r.header.snapshotSize != sizeof(GameSnapshot)) {
+        closeReplay(r);
+        return false;
+    }
+
+    ReplayFooter footer = {};
+    if (r.size >= sizeof(ReplayHeader) + sizeof(ReplayFooter)) memcpy(&footer, r.data + r.size - sizeof(footer), sizeof(footer));
+    size_t indexBytes = (size_t)footer.keyframeCount * sizeof(ReplayIndexEntry);
+    if (footer.magic == REPLAY_MAGIC && footer.indexOffset + indexBytes + sizeof(footer) == r.size) {
+        r.index.resize(footer.keyframeCount);
+        memcpy(r.index.data(), r.data + footer.indexOffset, indexBytes);
+        r.tickCount = footer.tickCount;
+    } else {
+        r.tickCount = 0;
+        size_t offset = sizeof(ReplayHeader);
+        while (offset + sizeof(ReplayEvent) <= r.size) {
+            ReplayEvent event;
+            memcpy(&event, r.data + offset, sizeof(event));
+            if (event.type == REPLAY_KEYFRAME) {
+                if (offset + sizeof(event) + sizeof(GameSnapshot) > r.size) break;
+                r.index.push_back({r.tickCount, offset});
+                offset += sizeof(event) + sizeof(GameSnapshot);
+            } else {
+                r.tickCount++;
+                offset += sizeof(event);
+            }
+        }
+        std::cout << "Replay " << path << " has no index (session cut short?); rebuilt it by scanning.\n";
+    }
+    if (r.index.empty()) {
+        closeReplay(r);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Restores the keyframe whose marker is at `offset` and returns the offset past it.
+ * Level starts are always followed by a keyframe, so re-simulation picks up the recorded
+ * items and ambushers rather than placing them again.
+ */
+size_t restoreReplayKeyframe(const ReplayReader& r, size_t offset) {
+    GameSnapshot snapshot;
+    offset += sizeof(ReplayEvent);
+    memcpy(&snapshot, r.data + offset, sizeof(GameSnapshot)); // The mapping is not aligned for GameSnapshot.
+    restoreGame(snapshot);
+    return offset + sizeof(GameSnapshot);
+}
+
+/**
+ * @brief Puts the live game in the state reached after the first `tick` events: restores
+ * the last keyframe at or before that tick and re-simulates the remaining events, fewer
+ * than REPLAY_KEYFRAME_INTERVAL. Ticks past the end clamp to the end.
+ * @param nextOffset If given, receives the file offset of the next unapplied event.
+ * @return The tick actually reached.
+ */
+uint64_t seekReplay(const ReplayReader& r, uint64_t tick, size_t* nextOffset = nullptr) {
+    tick = std::min(tick, r.tickCount);
+    auto it = std::upper_bound(r.index.begin(), r.index.end(), tick, [](uint64_t t, const ReplayIndexEntry& e) { return t < e.tick; });
+    const ReplayIndexEntry& keyframe = (it == r.index.begin()) ? r.index.front() : *(it - 1);
+    size_t offset = restoreReplayKeyframe(r, keyframe.offset);
+    uint64_t reached = keyframe.tick;
+    while (reached < tick && offset + sizeof(ReplayEvent) <= r.size) {
+        ReplayEvent event;
+        memcpy(&event, r.data + offset, sizeof(event));
+        offset += sizeof(event);
+        if (event.type == REPLAY_KEYFRAME) { offset = restoreReplayKeyframe(r, offset - sizeof(event)); continue; }
+        applyReplayEvent(event);
+        reached++;
+    }
+    if (nextOffset != nullptr) *nextOffset = offset;
+    return reached;
+}
+
+// --- Observation Encoder ---
+// Writes game states into caller-owned uint8 buffers for learning agents: one ROWS x COLS
+// plane per ObservationPlane (1 where the thing is, 0 elsewhere) followed by the scalar
+// features. Each environment keeps an ObservationEncoder holding the state it last wrote
+// into its buffer, so a step only rewrites the cells that changed; walls and item planes
+// are rewritten when the level or the item lists change. Nothing is allocated per step.
+// Walls come from the stock layouts, so tiles changed with setTile() are not reflected.
+enum ObservationPlane { OBS_WALLS, OBS_CHEESE, OBS_POWERUPS, OBS_PLAYER, OBS_CAT, OBS_AMBUSHERS, OBS_PLANE_COUNT };
+enum ObservationScalar { OBS_CAT_DELAY, OBS_CAT_SLOWED, OBS_LEVEL, OBS_CHEESE_LEFT, OBS_SCALAR_COUNT };
+const int OBS_PLANE_SIZE = ROWS * COLS;
+const int OBSERVATION_SIZE = OBS_PLANE_COUNT * OBS_PLANE_SIZE + OBS_SCALAR_COUNT;
+const int OBS_CAT_DELAY_UNIT_MS = 4; // The cat delay scalar counts 4 ms steps, capped at 255.
+
+struct ObservationEncoder {
+    GameSnapshot last;          // State currently encoded in `buffer`.
+    const uint8_t* buffer = nullptr; // Null until the first encode; a new buffer forces a full write.
+};
+
+uint8_t observationWalls[MAX_LEVELS + 1][OBS_PLANE_SIZE];
+std::once_flag observationWallsOnce[MAX_LEVELS + 1]; // chase_observe() runs unlocked, so first use may race.
+
+const uint8_t* observationWallPlane(int level) {
+    std::call_once(observationWallsOnce[level], [level] {
+        int tiles[ROWS][COLS];
+        std::vector<Portal> portals;
+        copyLevelLayout(level, tiles, portals);
+        for (int cell = 0; cell < OBS_PLANE_SIZE; ++cell) observationWalls[level][cell] = (tiles[cell / COLS][cell % COLS] == TILE_WALL);
+    });
+    return observationWalls[level];
+}
+
+template <typename List>
+void writeItemPlane(uint8_t* plane, const List& items, uint8_t value) {
+    for (const auto& item : items) plane[item.y * COLS + item.x] = value;
+}
+
+template <typename List>
+bool sameItems(const List& a, const List& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) if (a[i].x != b[i].x || a[i].y != b[i].y) return false;
+    return true;
+}
+
+/**
+ * @brief Encodes `state` into `out` (OBSERVATION_SIZE bytes), touching only what changed
+ * since the state this encoder last wrote into the same buffer.
+ */
+void encodeObservation(const GameSnapshot& state, uint8_t* out, ObservationEncoder& encoder) {
+    uint8_t* planes[OBS_PLANE_COUNT];
+    for (int p = 0; p < OBS_PLANE_COUNT; ++p) planes[p] = out + p * OBS_PLANE_SIZE;
+    const GameSnapshot& last = encoder.last;
+    bool full = (encoder.buffer != out);
+    int level = std::max(1, std::min(state.level, MAX_LEVELS)); // The win screen reports MAX_LEVELS + 1.
+    if (full) {
+        std::memset(out, 0, OBS_PLANE_COUNT * OBS_PLANE_SIZE);
+    } else {
+        // Clear what the previous state drew; the redraw below restores anything unchanged.
+        planes[OBS_PLAYER][last.playerY * COLS + last.playerX] = 0;
+        planes[OBS_CAT][last.catY * COLS + last.catX] = 0;
+        writeItemPlane(planes[OBS_AMBUSHERS], last.ambushers, 0);
+        if (!sameItems(last.cheese, state.cheese)) writeItemPlane(planes[OBS_CHEESE], last.cheese, 0);
+        if (!sameItems(last.powerups, state.powerups)) writeItemPlane(planes[OBS_POWERUPS], last.powerups, 0);
+    }
+    if (full || std::max(1, std::min(last.level, MAX_LEVELS)) != level) std::memcpy(planes[OBS_WALLS], observationWallPlane(level), OBS_PLANE_SIZE);
+    if (full || !sameItems(last.cheese, state.cheese)) writeItemPlane(planes[OBS_CHEESE], state.cheese, 1);
+    if (full || !sameItems(last.powerups, state.powerups)) writeItemPlane(planes[OBS_POWERUPS], state.powerups, 1);
+    planes[OBS_PLAYER][state.playerY * COLS + state.playerX] = 1;
+    planes[OBS_CAT][state.catY * COLS + state.catX] = 1;
+    writeItemPlane(planes[OBS_AMBUSHERS], state.ambushers, 1);
+
+    uint8_t* scalars = out + OBS_PLANE_COUNT * OBS_PLANE_SIZE;
+    scalars[OBS_CAT_DELAY] = std::min(255, state.catDelay / OBS_CAT_DELAY_UNIT_MS);
+    scalars[OBS_CAT_SLOWED] = state.catSlowed;
+    scalars[OBS_LEVEL] = state.level;
+    scalars[OBS_CHEESE_LEFT] = state.cheese.size();
+    std::memcpy(&encoder.last, &state, sizeof(GameSnapshot));
+    encoder.buffer = out;
+}
+
+/**
+ * @brief Encodes a batch of environments into one contiguous buffer of
+ * count * OBSERVATION_SIZE bytes, environment i at offset i * OBSERVATION_SIZE.
+ */
+void encodeObservationBatch(const GameSnapshot* states, int count, uint8_t* out, ObservationEncoder* encoders) {
+    for (int i = 0; i < count; ++i) encodeObservation(states[i], out + (size_t)i * OBSERVATION_SIZE, encoders[i]);
+}
+
+/**
+ * @brief Moves the cat one step towards the player using the selected pathfinder:
+ * the junction graph by default, cell-level BFS as the exact reference, HPA* for huge mazes,
+ * D* Lite, which repairs its previous search when tiles change at runtime, or a
+ * bidirectional BFS that stops as soon as the searches from cat and player meet.
+ * The predictive mode instead searches ahead over likely player moves, and the
+ * tablebase mode plays perfectly from a precomputed table where one is available.
+ * @return The cell the cat steps to, or -1 if it stays put.
+ */
+int catNextStep() {
+    int nextStepX = -1, nextStepY = -1;
+    bool found = false;
+    switch (catPathfinder) {
+        case PATHFINDER_BFS: found = bfsNextStep(catX, catY, playerX, playerY, nextStepX, nextStepY); break;
+        case PATHFINDER_JUNCTION: {
+            int step;
+            found = junctionNextStep(levelJunctions, catY * COLS + catX, playerY * COLS + playerX, step);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_HPA: {
+            int step;
+            found = hpaNextStep(levelHpa, catHpaChaser, catY * COLS + catX, playerY * COLS + playerX, step);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_BIDIRECTIONAL: {
+            int step;
+            found = bidirectionalNextStep(mazeGraph, catY * COLS + catX, playerY * COLS + playerX, step);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_PREDICTIVE: {
+            int step, depth;
+            int budget = std::min(PREDICTIVE_MAX_BUDGET_MS, (int)(currentCatDelay * PREDICTIVE_BUDGET_FRACTION));
+            if (predictiveInBackground) found = predictiveBackgroundStep(catY * COLS + catX, playerY * COLS + playerX, budget, step);
+            else found = predictiveNextStep(catY * COLS + catX, playerY * COLS + playerX, budget, step, depth);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_TABLEBASE: {
+            // Perfect play where a capture can be forced, otherwise plain pursuit.
+            int step;
+            if (tablebaseNextStep(catY * COLS + catX, playerY * COLS + playerX, step)) found = true;
+            else found = junctionNextStep(levelJunctions, catY * COLS + catX, playerY * COLS + playerX, step);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_PLAYER: {
+            // A second player steers; the cat keeps going the chosen way and waits at walls.
+            if (playerCatHeading < 0) break;
+            int cell = catY * COLS + catX, step = mazeGraph.moves[cell * 4 + playerCatHeading];
+            found = true;
+            if (step != cell) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+        case PATHFINDER_DSTAR: {
+            int step;
+            if (catDStar.graph == nullptr) dstarInit(catDStar, mazeGraph, levelPortals, catY * COLS + catX, playerY * COLS + playerX);
+            found = dstarNextStep(catDStar, catY * COLS + catX, playerY * COLS + playerX, step);
+            if (found && step != -1) { nextStepX = step % COLS; nextStepY = step / COLS; }
+            break;
+        }
+    }
+
+    return (found && nextStepX != -1) ? nextStepY * COLS + nextStepX : -1;
+}
+
+/**
+ * @brief The replay argument for a cat step: the Direction that leads there from the
+ * cat's cell, or REPLAY_CAT_STAY.
+ */
+uint8_t catStepDirection(int step) {
+    int cell = catY * COLS + catX;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (step != -1 && step != cell && mazeGraph.moves[cell * 4 + dir] == step) return (uint8_t)dir;
+    }
+    return REPLAY_CAT_STAY;
+}
+
+/**
+ * @brief Moves the cat to the given cell (-1 to stay put), then lets any ambushers take
+ * their own step (see moveAmbushers()) and checks for the capture.
+ */
+void moveCatTo(int step) {
+    // Update the cat's position if a valid step was found
+    if (step != -1) {
+        gameStateHash ^= zobristCat[catY * COLS + catX] ^ zobristCat[step];
+        catX = step % COLS;
+        catY = step / COLS;
+    }
+    if (!ambushers.empty()) {
+        updateChaserField(); // The ambushers see where the cat has just stepped.
+        moveAmbushers();
+    }
+    if (showSafeRouteHint) {
+        updateChaserField(); // The danger map only changes when chasers move.
+        updateSafeRoute();
+    }
+
+    // Check for collision with the player
+    bool caught = (catX == playerX && catY == playerY);
+    for (const auto& a : ambushers) caught = caught || (a.x == playerX && a.y == playerY);
+    if (caught && currentGameState == PLAYING) {
+        if (engineLog) std::cout << "Caught by the cat! Game Over. Current Level Score: " << score << std::endl;
+        totalScore += score;
+        score = 0;
+        currentGameState = GAME_OVER;
+        timerActive = false;
+        if (engineLog) std::cout << "Final Total Score: " << totalScore << std::endl;
+    }
+}
+
+/**
+ * @brief Moves the cat one step towards the player using the selected pathfinder.
+ */
+void moveCat() {
+    moveCatTo(catNextStep());
+}
+
+#ifndef CHASE_LIBRARY
+/**
+ * @brief Timer callback that triggers the cat's movement periodically.
+ * @param value A unique identifier to prevent multiple timers from running after a reset.
+ */
+void catTimer(int value) {
+    if (value != resetIdentifier && currentGameState != START_MENU) {
+        return;
+    }
+    if (currentGameState == PLAYING && timerActive) {
+        if (!isCatSlowed) {
+            int step = catNextStep();
+            recordReplayEvent(REPLAY_CAT_MOVE, catStepDirection(step));
+            moveCatTo(step);
+        }
+        glutTimerFunc(currentCatDelay, catTimer, resetIdentifier);
+    }
+}
+#endif // CHASE_LIBRARY
+
+
+// -----------------------------------------------------------------------------
+// USER INPUT AND SYSTEM CALLBACKS
+// -----------------------------------------------------------------------------
+
+#ifndef CHASE_LIBRARY
+/**
+ * @brief Handles all keyboard input from the user (ASCII characters).
+ * @param key The ASCII value of the key pressed.
+ * @param x_param Mouse X position (unused).
+ * @param y_param Mouse Y position (unused).
+ */
+void keyboard(unsigned char key, int x_param, int y_param) {
+    if (viewingReplay) { replayViewerKeyboard(key, x_param, y_param); return; }
+    if (networkClient) { networkClientKeyboard(key, x_param, y_param); return; }
+    if (versusMode) { versusKeyboard(key, x_param, y_param); return; }
+    // State machine for keyboard input
+    if (currentGameState == INTRO) {
+        currentGameState = START_MENU;
+        glutPostRedisplay();
+        return;
+    }
+    if (currentGameState == START_MENU) {
+        if (key == 13) { resetGame(); } // Enter key
+        else if (key == 27) { exit(0); } // Escape key
+        return;
+    }
+    if (currentGameState == GAME_OVER || currentGameState == GAME_WON_FINAL || currentGameState == GAME_WON_LEVEL) {
+        if ((key == 'r' || key == 'R') && currentGameState != GAME_WON_FINAL) { resetGame(); }
+        else if (key == 27) { exit(0); }
+        return;
+    }
+
+    // General controls (available in multiple states)
+    if (key == 'p' || key == 'P') {
+         if (currentGameState == PLAYING) {
+             recordReplayEvent(REPLAY_PAUSE, 1);
+             currentGameState = PAUSED;
+             timerActive = false;
+             std::cout << "Game Paused.\n";
+             glutPostRedisplay();
+         } else if (currentGameState == PAUSED) {
+             recordReplayEvent(REPLAY_PAUSE, 0);
+             currentGameState = PLAYING;
+             timerActive = true;
+             lastTickTime = glutGet(GLUT_ELAPSED_TIME);
+             resetIdentifier++;
+             catTimer(resetIdentifier);
+             std::cout << "Game Resumed.\n";
+             glutPostRedisplay();
+         }
+         return;
+    }
+    if (key == 27) exit(0);
+
+    // Gameplay controls (only active when playing)
+    if (currentGameState != PLAYING) return;
+    if (key == 'r' || key == 'R') {
+        resetGame();
+        return;
+    }
+    if (key == 'h' || key == 'H') {
+        showSafeRouteHint = !showSafeRouteHint;
+        updateChaserField();
+        updateSafeRoute();
+        glutPostRedisplay();
+        return;
+    }
+
+    Direction dir;
+    switch (key) {
+        case 'w': case 'W': dir = DIR_UP; break;
+        case 's': case 'S': dir = DIR_DOWN; break;
+        case 'a': case 'A': dir = DIR_LEFT; break;
+        case 'd': case 'D': dir = DIR_RIGHT; break;
+        default: return;
+    }
+    processPlayerMove(dir);
+}
+
+/**
+ * @brief Handles special keyboard input (e.g., arrow keys).
+ * @param key The GLUT constant for the special key pressed.
+ * @param x Mouse X position (unused).
+ * @param y Mouse Y position (unused).
+ */
+void specialKeyboard(int key, int x, int y) {
+    if (viewingReplay) { replayViewerSpecialKeyboard(key, x, y); return; }
+    if (networkClient) { networkClientSpecialKeyboard(key, x, y); return; }
+    if (versusMode) { versusSpecialKeyboard(key, x, y); return; }
+    if (currentGameState != PLAYING) return;
+
+    Direction dir;
     switch (key) {
-        case GLUT_KEY_UP:    nextY--; break;
-        case GLUT_KEY_DOWN:  nextY++; break;
-        case GLUT_KEY_LEFT:  nextX--; break;
-        case GLUT_KEY_RIGHT: nextX++; break;
+        case GLUT_KEY_UP:    dir = DIR_UP; break;
+        case GLUT_KEY_DOWN:  dir = DIR_DOWN; break;
+        case GLUT_KEY_LEFT:  dir = DIR_LEFT; break;
+        case GLUT_KEY_RIGHT: dir = DIR_RIGHT; break;
         default: return;
     }
-    processPlayerMove(nextX, nextY);
+    processPlayerMove(dir);
+}
+#endif // CHASE_LIBRARY
+
+// --- Replay Viewer ---
+// Space plays or pauses, Left/Right step one event, Down/Up jump 100 events,
+// Page Down/Up jump 10,000 and Home/End go to either end of the recording.
+const int REPLAY_VIEWER_STEP_MS = 60;
+ReplayReader replayViewer;
+uint64_t replayViewerTick = 0;
+size_t replayViewerOffset = 0; // File offset of the next event during playback.
+bool replayViewerPlaying = false;
+double lastReplaySeekMs = 0.0;
+
+#ifndef CHASE_LIBRARY
+void replayViewerSeek(int64_t tick) {
+    auto t0 = std::chrono::steady_clock::now();
+    replayViewerTick = seekReplay(replayViewer, (uint64_t)std::max<int64_t>(tick, 0), &replayViewerOffset);
+    lastReplaySeekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    glutPostRedisplay();
+}
+
+/**
+ * @brief Plays the recording forward one visible event per step; slowdown timer events
+ * carry no movement, so they are applied in the same step as the event that follows.
+ */
+void replayViewerTimer(int value) {
+    if (!replayViewerPlaying) return;
+    bool moved = false;
+    while (!moved && replayViewerTick < replayViewer.tickCount && replayViewerOffset + sizeof(ReplayEvent) <= replayViewer.size) {
+        ReplayEvent event;
+        memcpy(&event, replayViewer.data + replayViewerOffset, sizeof(event));
+        replayViewerOffset += sizeof(event);
+        if (event.type == REPLAY_KEYFRAME) { replayViewerOffset = restoreReplayKeyframe(replayViewer, replayViewerOffset - sizeof(event)); continue; }
+        applyReplayEvent(event);
+        replayViewerTick++;
+        moved = (event.type != REPLAY_SLOW_TIMER);
+    }
+    if (replayViewerTick >= replayViewer.tickCount) replayViewerPlaying = false;
+    glutPostRedisplay();
+    if (replayViewerPlaying) glutTimerFunc(REPLAY_VIEWER_STEP_MS, replayViewerTimer, 0);
+}
+
+void replayViewerKeyboard(unsigned char key, int x, int y) {
+    if (key == 27) exit(0);
+    if (key == ' ') {
+        replayViewerPlaying = !replayViewerPlaying;
+        if (replayViewerPlaying) glutTimerFunc(REPLAY_VIEWER_STEP_MS, replayViewerTimer, 0);
+        glutPostRedisplay();
+    }
+}
+
+void replayViewerSpecialKeyboard(int key, int x, int y) {
+    int64_t tick = replayViewerTick;
+    switch (key) {
+        case GLUT_KEY_LEFT:      replayViewerSeek(tick - 1); break;
+        case GLUT_KEY_RIGHT:     replayViewerSeek(tick + 1); break;
+        case GLUT_KEY_DOWN:      replayViewerSeek(tick - 100); break;
+        case GLUT_KEY_UP:        replayViewerSeek(tick + 100); break;
+        case GLUT_KEY_PAGE_DOWN: replayViewerSeek(tick - 10000); break;
+        case GLUT_KEY_PAGE_UP:   replayViewerSeek(tick + 10000); break;
+        case GLUT_KEY_HOME:      replayViewerSeek(0); break;
+        case GLUT_KEY_END:       replayViewerSeek(replayViewer.tickCount); break;
+    }
+}
+
+void drawReplayViewerBar() {
+    std::stringstream ss;
+    ss << "Replay " << replayViewerTick << " / " << replayViewer.tickCount << (replayViewerPlaying ? "  (playing)" : "")
+       << "   last seek " << lastReplaySeekMs << " ms";
+    renderCenteredText(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 8.0f, ss.str(), GLUT_BITMAP_9_BY_15, 0.9f, 0.9f, 0.5f);
+}
+
+/**
+ * @brief Centralized logic to handle player movement and collisions.
+ * This is called by both keyboard() and specialKeyboard() to avoid code duplication.
+ * @param dir The direction the player wants to step in.
+ */
+void processPlayerMove(Direction dir) {
+    recordReplayEvent(REPLAY_PLAYER_MOVE, dir);
+    if (!applyPlayerMove(dir)) return;
+    if (currentGameState != PLAYING) nextLevel(); // That was the last cheese.
+    glutPostRedisplay();
+}
+#endif // CHASE_LIBRARY
+
+/**
+ * @brief Moves the player and resolves cheese and power-up pickups, without touching the window.
+ * @return True if the player actually moved.
+ */
+bool applyPlayerMove(Direction dir) {
+    // The compiled maze graph already resolves walls and portals for each direction
+    int cell = playerY * COLS + playerX;
+    int nextCell = mazeGraph.moves[cell * 4 + dir];
+    if (nextCell != cell) {
+        gameStateHash ^= zobristPlayer[cell] ^ zobristPlayer[nextCell];
+        playerHeading = dir;
+        playerX = nextCell % COLS;
+        playerY = nextCell / COLS;
+
+        // Check for collision with cheese
+        for (auto it = cheeseLocations.begin(); it != cheeseLocations.end(); ) {
+            if (it->x == playerX && it->y == playerY) {
+                it = cheeseLocations.erase(it);
+                gameStateHash ^= zobristCheese[nextCell];
+                score++;
+                if (engineLog) std::cout << "Collected Cheese! Level Score: " << score << " (Current Total: " << totalScore + score << ")" << std::endl;
+
+                // Increase cat speed as cheese is collected (non-linear scaling)
+                if (!isCatSlowed && initialCheeseCount > 0) {
+                    float progress = (float)score / initialCheeseCount;
+                    currentCatDelay = catDelayForProgress(currentSpeedCurve(), progress);
+                    normalCatDelayBeforeSlowdown = currentCatDelay;
+                    if (engineLog) std::cout << "Cat speed adjusted! New delay: " << currentCatDelay << "ms\n";
+                }
+
+                if (cheeseLocations.empty()) {
+                    advanceLevel();
+                    return true; // Exit to prevent further processing this frame
+                }
+                break;
+            } else {
+                ++it;
+            }
+        }
+
+        // Check for collision with power-ups
+        for (auto it = powerupLocations.begin(); it != powerupLocations.end(); ) {
+            if(it->x == playerX && it->y == playerY) {
+                if (it->type == TILE_SLOW_POWERUP && !isCatSlowed) {
+                    if (engineLog) std::cout << "Powerup Collected: Cat Slowdown!\n";
+                    int oldBucket = slowdownBucket();
+                    isCatSlowed = true;
+                    catSlowDurationTimer = CAT_SLOW_DURATION_MS;
+                    gameStateHash ^= zobristPowerup[nextCell] ^ zobristSlowed ^ zobristSlowBucket[oldBucket] ^ zobristSlowBucket[slowdownBucket()];
+                    normalCatDelayBeforeSlowdown = currentCatDelay;
+                    currentCatDelay = std::max(currentCatDelay, currentSpeedCurve().initialDelayMs + 100);
+                    if (engineLog) std::cout << "Cat slowed! Delay: " << currentCatDelay << "ms\n";
+                    it = powerupLocations.erase(it);
+                    break;
+                } else {
+                    ++it;
+                }
+            } else {
+                ++it;
+            }
+        }
+        updateSafeRoute();
+        return true;
+    }
+    return false;
+}
+
+#ifndef CHASE_LIBRARY
+/**
+ * @brief Sets up initial OpenGL states like blending and anti-aliasing.
+ */
+void initOpenGL() {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(0.0, WINDOW_WIDTH, WINDOW_HEIGHT, 0.0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glEnable(GL_LINE_SMOOTH);
+    glEnable(GL_POLYGON_SMOOTH);
+    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+    glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/**
+ * @brief Idle callback for time-based updates, such as animations and timers.
+ */
+void idle() {
+    int currentTime = glutGet(GLUT_ELAPSED_TIME);
+    int deltaTime = currentTime - lastTickTime;
+
+    if (deltaTime > 0) {
+        if (currentGameState == PLAYING || currentGameState == PAUSED) {
+            // Animate power-up sparkle effect
+            for(auto& p : powerupLocations) {
+                p.sparklePhase += deltaTime * 0.005f;
+                if (p.sparklePhase > TWICE_PI) p.sparklePhase -= TWICE_PI;
+            }
+            // Decrement the cat slowdown timer
+            if(isCatSlowed && currentGameState == PLAYING) {
+                int elapsed = std::min(deltaTime, (int)UINT16_MAX); // Fits a replay event.
+                recordReplayEvent(REPLAY_SLOW_TIMER, 0, elapsed);
+                advanceSlowdownTimer(elapsed);
+            }
+        }
+        lastTickTime = currentTime;
+    }
+    glutPostRedisplay();
+}
+#endif // CHASE_LIBRARY
+
+/**
+ * @brief Counts down the cat slowdown and restores the cat's speed when it runs out.
+ */
+void advanceSlowdownTimer(int deltaTime) {
+    int oldBucket = slowdownBucket();
+    catSlowDurationTimer -= deltaTime;
+    if(catSlowDurationTimer <= 0) {
+        isCatSlowed = false;
+        gameStateHash ^= zobristSlowed;
+        // Restore cat speed to its normal value for the current progress
+        if(initialCheeseCount > 0) {
+            float progress = (float)score / initialCheeseCount;
+            currentCatDelay = catDelayForProgress(currentSpeedCurve(), progress);
+        } else {
+            currentCatDelay = normalCatDelayBeforeSlowdown;
+        }
+        if (engineLog) std::cout << "Cat slowdown ended! Delay restored to: " << currentCatDelay << "ms\n";
+    }
+    gameStateHash ^= zobristSlowBucket[oldBucket] ^ zobristSlowBucket[slowdownBucket()];
+}
+
+#ifndef CHASE_LIBRARY
+/**
+ * @brief Reshape callback that maintains the game's aspect ratio.
+ * This function adds black bars (letterboxing/pillarboxing) if the window
+ * is resized to a non-proportional shape.
+ * @param w The new window width.
+ * @param h The new window height.
+ */
+void reshape(int w, int h) {
+    if (h == 0) h = 1;
+    float gameAspect = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
+    float windowAspect = (float)w / (float)h;
+
+    int newViewportW, newViewportH, newViewportX, newViewportY;
+
+    if (windowAspect > gameAspect) {
+        // Window is wider than the game (pillarbox)
+        newViewportH = h;
+        newViewportW = (int)(h * gameAspect);
+        newViewportX = (w - newViewportW) / 2;
+        newViewportY = 0;
+    } else {
+        // Window is taller than the game (letterbox)
+        newViewportW = w;
+        newViewportH = (int)(w / gameAspect);
+        newViewportX = 0;
+        newViewportY = (h - newViewportH) / 2;
+    }
+    glViewport(newViewportX, newViewportY, newViewportW, newViewportH);
+    glutPostRedisplay();
+}
+#endif // CHASE_LIBRARY
+
+
+// -----------------------------------------------------------------------------
+// HEADLESS TOOLS AND BENCHMARKS
+// -----------------------------------------------------------------------------
+
+// --- Discrete-Event Simulation ---
+// Headless games jump straight from one scheduled event to the next instead of stepping
+// every frame: nothing happens between cat moves, player inputs and the end of a slowdown.
+// The rules mirror advanceGameClock(), applyPlayerMove() and moveCat() with the BFS chaser,
+// and the mouse is played by a parameterized bot. They are a copy rather than calls into the
+// engine because the tuner plays games on worker threads and the engine's state is global, so
+// they diverge from a real game in two ways: the cat always takes the first shortest-path
+// step whatever catPathfinder says, and there are no ambushers. Tuned curves therefore fit the
+// BFS chaser (--pathfinder=bfs); the default junction chaser breaks ties between equally short
+// paths its own way. benchSimulator() replays games through the simulator and the engine's BFS
+// chaser and counts any that differ.
+const int SIM_TIME_LIMIT_MS = 10 * 60 * 1000; // Games still running after this count as losses.
+
+struct SimBot {
+    int inputIntervalMs = 150; // Time between the bot's moves.
+    int cautionDistance = 3;   // Flees instead of collecting when the cat is this close.
+    float mistakeRate = 0.05f; // Chance of a random move.
+};
+
+struct SimGame {
+    int player, cat;
+    int cheese[NUM_CHEESE_TO_PLACE];
+    int cheeseCount = 0, initialCheese = 0;
+    int powerups[NUM_POWERUPS_PER_LEVEL];
+    int powerupCount = 0;
+    bool slowed = false;
+    int catDelay = INITIAL_CAT_DELAY_MS;
+    int normalDelay = INITIAL_CAT_DELAY_MS;
+    int score = 0;
+};
+
+struct SimResult {
+    bool won = false;
+    bool caught = false;
+    int timeMs = 0;
+    int score = 0;
+    int events = 0;
+};
+
+// At most one event of each type is pending, so the schedule is one due time per type
+// rather than a queue. Events due at the same time run in advanceGameClock()'s order: the
+// slowdown ends, the cat moves, then the player's input is read.
+enum SimEventType { SIM_SLOW_END, SIM_CAT_MOVE, SIM_PLAYER_INPUT, SIM_EVENT_TYPES };
+const int SIM_NEVER = INT_MAX; // Due time of an event type with nothing scheduled.
+
+/**
+ * @brief Places cheese and power-ups on the current maze with the same rules as initLevelData().
+ */
+void simSetupLevel(SimGame& game, const CatSpeedCurve& curve, std::mt19937& rng) {
+    game = SimGame();
+    game.player = PLAYER_START_Y * COLS + PLAYER_START_X;
+    game.cat = CAT_START_Y * COLS + CAT_START_X;
+    game.catDelay = game.normalDelay = curve.initialDelayMs;
+    auto placeable = [&](int cell) {
+        if (maze[cell / COLS][cell % COLS] != TILE_PATH || cell == game.player || cell == game.cat) return false;
+        for (int i = 0; i < game.cheeseCount; ++i) if (game.cheese[i] == cell) return false;
+        for (int i = 0; i < game.powerupCount; ++i) if (game.powerups[i] == cell) return false;
+        return true;
+    };
+    const int maxAttempts = ROWS * COLS * 10;
+    for (int attempts = 0; game.cheeseCount < NUM_CHEESE_TO_PLACE && attempts < maxAttempts; ++attempts) {
+        int cell = rng() % (ROWS * COLS);
+        if (placeable(cell)) game.cheese[game.cheeseCount++] = cell;
+    }
+    for (int attempts = 0; game.powerupCount < NUM_POWERUPS_PER_LEVEL && attempts < maxAttempts; ++attempts) {
+        int cell = rng() % (ROWS * COLS);
+        if (placeable(cell)) game.powerups[game.powerupCount++] = cell;
+    }
+    game.initialCheese = game.cheeseCount;
+}
+
+/**
+ * @brief Copies the live game's positions, items and cat speed into a simulator game.
+ */
+void simCaptureLiveGame(SimGame& game) {
+    game = SimGame();
+    game.player = playerY * COLS + playerX;
+    game.cat = catY * COLS + catX;
+    for (const auto& c : cheeseLocations) if (game.cheeseCount < NUM_CHEESE_TO_PLACE) game.cheese[game.cheeseCount++] = c.y * COLS + c.x;
+    for (const auto& p : powerupLocations) if (game.powerupCount < NUM_POWERUPS_PER_LEVEL) game.powerups[game.powerupCount++] = p.y * COLS + p.x;
+    game.initialCheese = initialCheeseCount;
+    game.slowed = isCatSlowed;
+    game.catDelay = currentCatDelay;
+    game.normalDelay = normalCatDelayBeforeSlowdown;
+    game.score = score;
+}
+
+/**
+ * @brief The bot's next cell: a random move by mistake, fleeing when the cat is close,
+ * otherwise heading for the nearest cheese (or power-up while the cat is at full speed).
+ */
+int simBotMove(const SimGame& game, const SimBot& bot, std::mt19937& rng) {
+    int cell = game.player;
+    int degree = mazeGraph.offsets[cell + 1] - mazeGraph.offsets[cell];
+    if (degree == 0) return cell;
+    if (std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < bot.mistakeRate) return mazeGraph.targets[mazeGraph.offsets[cell] + rng() % degree];
+
+    int catDistance = levelDistance(game.cat, cell);
+    bool flee = !game.slowed && catDistance >= 0 && catDistance <= bot.cautionDistance;
+    int goal = -1;
+    if (!flee) {
+        for (int i = 0; i < game.cheeseCount; ++i) {
+            if (goal == -1 || levelDistance(cell, game.cheese[i]) < levelDistance(cell, goal)) goal = game.cheese[i];
+        }
+        for (int i = 0; i < game.powerupCount && !game.slowed; ++i) {
+            if (goal == -1 || levelDistance(cell, game.powerups[i]) < levelDistance(cell, goal)) goal = game.powerups[i];
+        }
+        if (goal == -1) return cell;
+    }
+    int best = cell;
+    for (int i = mazeGraph.offsets[cell]; i < mazeGraph.offsets[cell + 1]; ++i) {
+        int next = mazeGraph.targets[i];
+        bool better = flee ? levelDistance(game.cat, next) > levelDistance(game.cat, best)
+                           : levelDistance(next, goal) < levelDistance(best, goal);
+        if (better) best = next;
+    }
+    return best;
+}
+
+/**
+ * @brief Plays a level of the current maze from the given state to the end without rendering.
+ */
+SimResult simulateGame(SimGame game, const SimBot& bot, const CatSpeedCurve& curve, std::mt19937& rng) {
+    SimResult result;
+    int due[SIM_EVENT_TYPES];
+    due[SIM_SLOW_END] = SIM_NEVER;
+    due[SIM_CAT_MOVE] = 0; // resetGame() starts the cat timer straight away.
+    due[SIM_PLAYER_INPUT] = bot.inputIntervalMs;
+    for (;;) {
+        int type = SIM_SLOW_END;
+        for (int t = type + 1; t < SIM_EVENT_TYPES; ++t) if (due[t] < due[type]) type = t;
+        int now = due[type];
+        if (now > SIM_TIME_LIMIT_MS) break;
+        result.timeMs = now;
+        result.events++;
+        if (type == SIM_CAT_MOVE) {
+            if (!game.slowed) {
+                // Same as moveCat(): step along a shortest path, then check for the capture.
+                int best = game.cat;
+                for (int i = mazeGraph.offsets[game.cat]; i < mazeGraph.offsets[game.cat + 1] && game.cat != game.player; ++i) {
+                    int next = mazeGraph.targets[i];
+                    if (best == game.cat || levelDistance(next, game.player) < levelDistance(best, game.player)) best = next;
+                }
+                game.cat = best;
+                if (game.cat == game.player) {
+                    result.caught = true;
+                    break;
+                }
+            }
+            due[SIM_CAT_MOVE] = now + game.catDelay;
+        } else if (type == SIM_SLOW_END) {
+            due[SIM_SLOW_END] = SIM_NEVER;
+            game.slowed = false;
+            game.catDelay = (game.initialCheese > 0) ? catDelayForProgress(curve, (float)game.score / game.initialCheese) : game.normalDelay;
+        } else {
+            // Same as processPlayerMove(): move, then collect cheese and power-ups.
+            game.player = simBotMove(game, bot, rng);
+            for (int i = 0; i < game.cheeseCount; ++i) {
+                if (game.cheese[i] != game.player) continue;
+                // Kept in order, like cheeseLocations, so the bot breaks ties the same way.
+                std::copy(game.cheese + i + 1, game.cheese + game.cheeseCount, game.cheese + i);
+                game.cheeseCount--;
+                game.score++;
+                if (!game.slowed) {
+                    game.catDelay = game.normalDelay = catDelayForProgress(curve, (float)game.score / game.initialCheese);
+                }
+                break;
+            }
+            if (game.cheeseCount == 0) {
+                result.won = true;
+                break;
+            }
+            for (int i = 0; i < game.powerupCount && !game.slowed; ++i) {
+                if (game.powerups[i] != game.player) continue;
+                std::copy(game.powerups + i + 1, game.powerups + game.powerupCount, game.powerups + i);
+                game.powerupCount--;
+                game.slowed = true;
+                game.normalDelay = game.catDelay;
+                game.catDelay = std::max(game.catDelay, curve.initialDelayMs + 100);
+                due[SIM_SLOW_END] = now + CAT_SLOW_DURATION_MS;
+                break;
+            }
+            due[SIM_PLAYER_INPUT] = now + bot.inputIntervalMs;
+        }
+    }
+    result.score = game.score;
+    return result;
+}
+
+/**
+ * @brief Plays one level of the current maze, with freshly placed items, to the end.
+ */
+SimResult simulateLevel(const SimBot& bot, const CatSpeedCurve& curve, std::mt19937& rng) {
+    SimGame game;
+    simSetupLevel(game, curve, rng);
+    return simulateGame(game, bot, curve, rng);
+}
+
+// --- Difficulty Tuner ---
+// Fits each level's speed curve to a target win rate for a mix of bot players. For each
+// candidate exponent both delays are scaled by one factor found by bisection (a slower cat
+// is easier, so the win rate rises with the factor). Game g always uses seed g, so two
+// evaluations differ only by their curve and not by luck.
+const float DIFFICULTY_TARGET_WIN_RATES[MAX_LEVELS + 1] = {0.0f, 0.75f, 0.6f, 0.45f};
+const float DIFFICULTY_EXPONENTS[] = {0.5f, 0.35f, 0.75f, 1.0f}; // The original curve wins ties.
+const int DIFFICULTY_BISECTION_STEPS = 10;
+const SimBot DIFFICULTY_BOTS[] = {{220, 2, 0.15f}, {150, 3, 0.05f}, {110, 5, 0.01f}}; // Novice, average, expert.
+const int DIFFICULTY_BOT_COUNT = sizeof(DIFFICULTY_BOTS) / sizeof(DIFFICULTY_BOTS[0]);
+
+/**
+ * @brief The default curve with both delays scaled by a factor.
+ */
+CatSpeedCurve scaledSpeedCurve(float factor, float exponent) {
+    CatSpeedCurve curve;
+    curve.initialDelayMs = (int)std::lround(INITIAL_CAT_DELAY_MS * factor);
+    curve.minDelayMs = std::max(30, (int)std::lround(MIN_CAT_DELAY_MS * factor));
+    curve.exponent = exponent;
+    return curve;
+}
+
+/**
+ * @brief Fraction of games the bot population wins on the current maze, played in parallel.
+ */
+float evaluateWinRate(WorkerPool& pool, const CatSpeedCurve& curve, int games) {
+    ensureLevelDistances();
+    const int chunk = 256;
+    std::atomic<int> nextGame(0), wins(0);
+    poolRun(pool, [&](int) {
+        int localWins = 0;
+        for (int start = nextGame.fetch_add(chunk); start < games; start = nextGame.fetch_add(chunk)) {
+            for (int game = start; game < std::min(games, start + chunk); ++game) {
+                std::mt19937 rng(game);
+                localWins += simulateLevel(DIFFICULTY_BOTS[game % DIFFICULTY_BOT_COUNT], curve, rng).won;
+            }
+        }
+        wins += localWins;
+    });
+    return (float)wins / games;
+}
+
+/**
+ * @brief Tuner entry point: main --tune-difficulty [directory] [gamesPerEvaluation].
+ * Writes the fitted curves to DIFFICULTY_FILE, which the game reads at startup.
+ */
+int runDifficultyTuner(int argc, char** argv) {
+    std::string directory = (argc > 2) ? argv[2] : ".";
+    int games = (argc > 3) ? std::max(1, atoi(argv[3])) : 10000;
+    WorkerPool pool;
+    poolStart(pool, 0);
+    std::string path = directory + "/" + DIFFICULTY_FILE;
+    std::ofstream out(path);
+    if (!out) {
+        std::cout << "Cannot write " << path << "\n";
+        poolStop(pool);
+        return 1;
+    }
+    out << "# Cat speed curves fitted by --tune-difficulty, " << games << " games per evaluation.\n";
+    auto t0 = std::chrono::steady_clock::now();
+    long long totalGames = 0;
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        float target = DIFFICULTY_TARGET_WIN_RATES[level];
+        CatSpeedCurve best;
+        float bestRate = -1.0f;
+        for (float exponent : DIFFICULTY_EXPONENTS) {
+            float low = 0.3f, high = 3.0f;
+            for (int step = 0; step < DIFFICULTY_BISECTION_STEPS; ++step) {
+                float mid = 0.5f * (low + high);
+                float rate = evaluateWinRate(pool, scaledSpeedCurve(mid, exponent), games);
+                (rate < target ? low : high) = mid;
+            }
+            CatSpeedCurve curve = scaledSpeedCurve(0.5f * (low + high), exponent);
+            float rate = evaluateWinRate(pool, curve, games);
+            totalGames += (long long)games * (DIFFICULTY_BISECTION_STEPS + 1);
+            if (bestRate < 0.0f || fabs(rate - target) < fabs(bestRate - target)) {
+                best = curve;
+                bestRate = rate;
+            }
+        }
+        std::cout << "Level " << level << ": " << best.initialDelayMs << " -> " << best.minDelayMs << " ms, exponent " << best.exponent
+                  << ", bot win rate " << bestRate << " (target " << target << ")\n";
+        out << "# Level " << level << ": bot win rate " << bestRate << ", target " << target << "\n";
+        out << "level " << level << " initial_delay_ms " << best.initialDelayMs << " min_delay_ms " << best.minDelayMs
+            << " exponent " << best.exponent << "\n";
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Simulated " << totalGames << " games on " << poolSize(pool) << " threads in " << seconds << " s. Wrote " << path << "\n";
+    poolStop(pool);
+    return 0;
+}
+
+// --- Replay Analytics ---
+// Re-simulates a directory of recorded sessions and aggregates where players go, where
+// they are caught, the order cheese is picked up in, how long levels take and what ends
+// them. The engine keeps its state in globals, so the corpus is split across forked
+// worker processes (one per core) that each sum into their own slot of a shared mapping.
+// Level times are estimated from the cat's move delays plus the slowdown ticks, since
+// replays record events rather than wall-clock time.
+const uint32_t REPLAY_STATS_MAGIC = 0x53524d43; // "CMRS"
+const uint32_t REPLAY_STATS_VERSION = 1;
+const int COMPLETION_BUCKET_MS = 5000;
+const int COMPLETION_BUCKETS = 60;                  // The last bucket holds everything slower.
+const int DEATH_CAUSES = 1 + PERSONALITY_COUNT;     // The main cat, then one per ambusher personality.
+
+struct ReplayStats {
+    uint64_t files, failedFiles, ticks;
+    uint64_t visits[MAX_LEVELS + 1][ROWS * COLS];         // Cells the player moved onto.
+    uint64_t captures[MAX_LEVELS + 1][ROWS * COLS];       // Where the player was caught.
+    uint64_t pickups[MAX_LEVELS + 1][ROWS * COLS];        // Cheese collected on each cell...
+    uint64_t pickupOrderSum[MAX_LEVELS + 1][ROWS * COLS]; // ...and the sum of its pickup order (0 = first).
+    uint64_t levelStarts[MAX_LEVELS + 1];
+    uint64_t completions[MAX_LEVELS + 1];
+    uint64_t completionMsSum[MAX_LEVELS + 1];
+    uint64_t completionHistogram[MAX_LEVELS + 1][COMPLETION_BUCKETS];
+    uint64_t deaths[MAX_LEVELS + 1][DEATH_CAUSES];
+    uint64_t abandoned[MAX_LEVELS + 1]; // Levels left by a reset or the end of the recording.
+};
+
+struct ReplayStatsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rows, cols;
+    uint32_t maxLevels;
+    uint32_t deathCauses;
+    uint32_t completionBuckets;
+    uint32_t completionBucketMs;
+};
+
+/**
+ * @brief Re-simulates one recording from its first keyframe and adds it to the totals.
+ */
+void analyzeReplay(const ReplayReader& r, ReplayStats& stats) {
+    catPathfinder = (CatPathfinder)r.header.pathfinder;
+    std::copy(r.header.speedCurves, r.header.speedCurves + MAX_LEVELS + 1, levelSpeedCurves);
+    size_t offset;
+    seekReplay(r, r.index.front().tick, &offset);
+    bool inLevel = (currentGameState == PLAYING || currentGameState == PAUSED);
+    int levelMs = 0;
+    for (uint64_t tick = r.index.front().tick; tick < r.tickCount && offset + sizeof(ReplayEvent) <= r.size; ++tick) {
+        ReplayEvent event;
+        memcpy(&event, r.data + offset, sizeof(event));
+        offset += sizeof(event);
+        if (event.type == REPLAY_KEYFRAME) { offset = restoreReplayKeyframe(r, offset - sizeof(event)); --tick; continue; }
+        int level = currentLevel;
+        int cheeseBefore = cheeseLocations.size();
+        int cellBefore = playerY * COLS + playerX;
+        GameState stateBefore = currentGameState;
+        if (event.type == REPLAY_CAT_MOVE) levelMs += currentCatDelay;
+        if (event.type == REPLAY_SLOW_TIMER) levelMs += event.value;
+        if ((event.type == REPLAY_NEW_GAME || event.type == REPLAY_START_LEVEL) && inLevel) stats.abandoned[level]++;
+        applyReplayEvent(event);
+        stats.ticks++;
+
+        int cell = playerY * COLS + playerX;
+        switch (event.type) {
+            case REPLAY_NEW_GAME:
+            case REPLAY_START_LEVEL:
+                stats.levelStarts[currentLevel]++;
+                inLevel = true;
+                levelMs = 0;
+                break;
+            case REPLAY_PLAYER_MOVE:
+                if (cell == cellBefore) break;
+                stats.visits[level][cell]++;
+                if ((int)cheeseLocations.size() < cheeseBefore) {
+                    stats.pickups[level][cell]++;
+                    stats.pickupOrderSum[level][cell] += initialCheeseCount - cheeseBefore;
+                }
+                if (currentGameState == GAME_WON_LEVEL || currentGameState == GAME_WON_FINAL) {
+                    stats.completions[level]++;
+                    stats.completionMsSum[level] += levelMs;
+                    stats.completionHistogram[level][std::min(levelMs / COMPLETION_BUCKET_MS, COMPLETION_BUCKETS - 1)]++;
+                    inLevel = false;
+                }
+                break;
+            case REPLAY_CAT_MOVE:
+                if (stateBefore == PLAYING && currentGameState == GAME_OVER) {
+                    int cause = 0;
+                    if (catX != playerX || catY != playerY) {
+                        for (const auto& a : ambushers) if (a.x == playerX && a.y == playerY) { cause = 1 + a.personality; break; }
+                    }
+                    stats.captures[level][cell]++;
+                    stats.deaths[level][cause]++;
+                    inLevel = false;
+                }
+                break;
+        }
+    }
+    if (inLevel) stats.abandoned[currentLevel]++;
+}
+
+void addReplayStats(ReplayStats& total, const ReplayStats& part) {
+    // Every field is a uint64_t counter, so the block can be summed as a flat array.
+    static_assert(sizeof(ReplayStats) % sizeof(uint64_t) == 0, "ReplayStats must hold only counters");
+    uint64_t* to = reinterpret_cast<uint64_t*>(&total);
+    const uint64_t* from = reinterpret_cast<const uint64_t*>(&part);
+    for (size_t i = 0; i < sizeof(ReplayStats) / sizeof(uint64_t); ++i) to[i] += from[i];
+}
+
+/**
+ * @brief Analyzes the files a worker claims from the shared counter until none are left.
+ */
+void analyzeReplayShard(const std::vector<std::string>& files, std::atomic<size_t>& next, ReplayStats& stats) {
+    ReplayReader reader;
+    for (size_t i = next++; i < files.size(); i = next++) {
+        if (!openReplay(reader, files[i])) { stats.failedFiles++; continue; }
+        analyzeReplay(reader, stats);
+        stats.files++;
+        closeReplay(reader);
+    }
+}
+
+bool writeReplayStats(const std::string& directory, const ReplayStats& stats) {
+    std::ofstream bin(directory + "/replay_stats.bin", std::ios::binary);
+    ReplayStatsHeader header = {REPLAY_STATS_MAGIC, REPLAY_STATS_VERSION, ROWS, COLS, MAX_LEVELS, DEATH_CAUSES, COMPLETION_BUCKETS, COMPLETION_BUCKET_MS};
+    bin.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bin.write(reinterpret_cast<const char*>(&stats), sizeof(stats));
+
+    std::ofstream heatmap(directory + "/replay_heatmap.csv");
+    heatmap << "level,x,y,visits,captures,cheese_pickups,mean_pickup_order\n";
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        for (int cell = 0; cell < ROWS * COLS; ++cell) {
+            uint64_t pickups = stats.pickups[level][cell];
+            if (stats.visits[level][cell] == 0 && stats.captures[level][cell] == 0 && pickups == 0) continue;
+            heatmap << level << "," << cell % COLS << "," << cell / COLS << "," << stats.visits[level][cell] << "," << stats.captures[level][cell]
+                    << "," << pickups << ",";
+            if (pickups > 0) heatmap << (double)stats.pickupOrderSum[level][cell] / pickups;
+            heatmap << "\n";
+        }
+    }
+
+    std::ofstream levels(directory + "/replay_levels.csv");
+    levels << "level,started,completed,mean_completion_ms,abandoned,caught_by_cat";
+    for (const char* name : PERSONALITY_NAMES) levels << ",caught_by_" << name;
+    levels << "\n";
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        levels << level << "," << stats.levelStarts[level] << "," << stats.completions[level] << ",";
+        if (stats.completions[level] > 0) levels << (double)stats.completionMsSum[level] / stats.completions[level];
+        levels << "," << stats.abandoned[level];
+        for (int cause = 0; cause < DEATH_CAUSES; ++cause) levels << "," << stats.deaths[level][cause];
+        levels << "\n";
+    }
+    return bin && heatmap && levels;
+}
+
+/**
+ * @brief Analytics entry point: main --analyze-replays [directory] [output directory].
+ * Every *.replay file in the directory is re-simulated; results go to replay_stats.bin,
+ * replay_heatmap.csv and replay_levels.csv.
+ */
+int runReplayAnalytics(int argc, char** argv) {
+    std::string directory = (argc > 2) ? argv[2] : ".";
+    std::string outDirectory = (argc > 3) ? argv[3] : directory;
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".replay") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty()) {
+        std::cout << "No .replay files in " << directory << "\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ReplayStats* total = new ReplayStats();
+    int workers = 1;
+#ifndef _WIN32
+    workers = std::max(1, std::min((int)files.size(), (int)std::thread::hardware_concurrency()));
+    // Worker slots plus the shared file counter, visible to every forked process.
+    size_t sharedSize = sizeof(ReplayStats) * workers + sizeof(std::atomic<size_t>);
+    void* shared = mmap(nullptr, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        std::cout << "Could not map shared memory for workers\n";
+        return 1;
+    }
+    ReplayStats* slots = static_cast<ReplayStats*>(shared);
+    std::atomic<size_t>* next = new (slots + workers) std::atomic<size_t>(0);
+    std::cout.flush();
+    std::vector<pid_t> children;
+    for (int w = 0; w < workers; ++w) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            engineLog = false; // The engine logs pickups and captures.
+            analyzeReplayShard(files, *next, slots[w]);
+            _exit(0);
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    bool workersOk = !children.empty();
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        workersOk = workersOk && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    if (workersOk) {
+        for (int w = 0; w < workers; ++w) addReplayStats(*total, slots[w]);
+    } else {
+        std::cout << "A worker failed\n";
+    }
+    munmap(shared, sharedSize);
+    if (!workersOk) return 1;
+#else
+    std::atomic<size_t> next(0);
+    engineLog = false;
+    analyzeReplayShard(files, next, *total);
+    engineLog = true;
+#endif
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    bool written = writeReplayStats(outDirectory, *total);
+    std::cout << "Analyzed " << total->files << " replays (" << total->failedFiles << " unreadable), " << total->ticks << " events in "
+              << seconds << " s on " << workers << " processes: " << total->ticks / std::max(seconds, 1e-9) / 1e6 << " M events/s\n";
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        uint64_t deaths = 0;
+        for (int cause = 0; cause < DEATH_CAUSES; ++cause) deaths += total->deaths[level][cause];
+        std::cout << "Level " << level << ": " << total->levelStarts[level] << " started, " << total->completions[level] << " completed, "
+                  << deaths << " caught, " << total->abandoned[level] << " abandoned\n";
+    }
+    std::cout << (written ? "Wrote " : "Could not write all of ") << outDirectory << "/replay_stats.bin, replay_heatmap.csv and replay_levels.csv\n";
+    delete total;
+    return written ? 0 : 1;
+}
+
+/**
+ * @brief Offline solver entry point: main --solve-tablebase [directory].
+ * Solves every built-in layout, writes one tablebase file per level and prints
+ * exact difficulty numbers for level designers.
+ */
+int runTablebaseSolver(int argc, char** argv) {
+    std::string directory = (argc > 2) ? argv[2] : ".";
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<uint16_t> entries;
+        auto t0 = std::chrono::steady_clock::now();
+        int n = solveTablebase(mazeGraph, entries);
+        double solveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::string path = tablebasePath(directory, level);
+        if (!writeTablebase(path, mazeGraph, n, entries)) {
+            std::cerr << "Could not write " << path << "\n";
+            return 1;
+        }
+
+        long long lost = 0, positions = 0;
+        int longest = 0;
+        for (int m = 0; m < n; ++m) {
+            for (int c = 0; c < n; ++c) {
+                if (m == c) continue;
+                uint16_t value = entries[tablebaseIndex(n, TABLEBASE_MOUSE_TO_MOVE, m, c)];
+                positions++;
+                if (value != TABLEBASE_ESCAPABLE) { lost++; longest = std::max<int>(longest, value); }
+            }
+        }
+        Tablebase tb;
+        loadTablebase(tb, path, mazeGraph);
+        uint16_t start = tb.entries ? tablebaseLookup(tb, PLAYER_START_Y * COLS + PLAYER_START_X, CAT_START_Y * COLS + CAT_START_X, TABLEBASE_MOUSE_TO_MOVE) : TABLEBASE_ESCAPABLE;
+        unloadTablebase(tb);
+        std::cout << "Level " << level << ": " << 2LL * n * n << " positions solved in " << solveMs << " ms -> " << path << "\n";
+        std::cout << "  Mouse-to-move positions lost for the mouse: " << 100.0 * lost / positions << "% (longest forced capture "
+                  << longest << " plies)\n";
+        std::cout << "  From the start positions: " << (start == TABLEBASE_ESCAPABLE ? std::string("escapable") : std::to_string(start) + " plies to capture") << "\n";
+    }
+    return 0;
+}
+
+/**
+ * @brief Compares HPA* against the exact BFS on a generated maze.
+ * Every query walks a chaser all the way to a fixed goal, so both the per-tick
+ * cost and the quality of the resulting path are measured.
+ */
+void benchHpa(const MazeGraph& graph, const std::vector<int>& cells, int queries, std::mt19937& rng) {
+    auto t0 = std::chrono::steady_clock::now();
+    HpaGraph hpa;
+    hpaBuild(hpa, graph, HPA_SECTOR_SIZE);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    long long bfsExpanded = 0, hpaTouched = 0, hpaTicks = 0, exactLength = 0, hpaLength = 0;
+    int maxTickTouched = 0, reachable = 0, reached = 0;
+    std::vector<int> dist;
+    for (int q = 0; q < queries; ++q) {
+        int start = cells[rng() % cells.size()], goal = cells[rng() % cells.size()];
+        bfsExpanded += bfsDistanceField(graph, {start}, dist, goal);
+        if (dist[goal] <= 0) continue;
+        reachable++;
+        exactLength += dist[goal];
+        HpaChaser chaser;
+        int cell = start, steps = 0;
+        while (cell != goal && steps <= 4 * dist[goal]) {
+            int step;
+            if (!hpaNextStep(hpa, chaser, cell, goal, step) || step == -1) break;
+            hpaTouched += lastSearchNodesTouched;
+            maxTickTouched = std::max(maxTickTouched, lastSearchNodesTouched);
+            hpaTicks++;
+            cell = step;
+            steps++;
+        }
+        hpaLength += steps;
+        if (cell == goal) reached++;
+    }
+    std::cout << "HPA*: " << hpa.sectorsX * hpa.sectorsY << " sectors built in " << buildMs << " ms\n";
+    std::cout << "  BFS expanded per query:       " << (double)bfsExpanded / queries << "\n";
+    std::cout << "  HPA* touched per tick (avg):  " << (hpaTicks ? (double)hpaTouched / hpaTicks : 0.0) << "  (max " << maxTickTouched << ", on a replan capped at " << HPA_MAX_PLAN_EXPANSIONS << " entrances)\n";
+    std::cout << "  Path length vs exact:         " << (exactLength ? (double)hpaLength / exactLength : 0.0) << "x (" << reached << "/" << reachable << " goals reached)\n";
+}
+
+/**
+ * @brief Compares the junction graph against the exact BFS on a generated maze, and checks
+ * that every first step it picks lies on a shortest path.
+ */
+void benchJunctionGraph(const MazeGraph& graph, const std::vector<int>& cells, int queries, std::mt19937& rng) {
+    auto t0 = std::chrono::steady_clock::now();
+    JunctionGraph junctions;
+    buildJunctionGraph(junctions, graph);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    long long bfsExpanded = 0, junctionSettled = 0;
+    double junctionMs = 0.0;
+    int wrongSteps = 0;
+    std::vector<int> dist;
+    for (int q = 0; q < queries; ++q) {
+        int from = cells[rng() % cells.size()], to = cells[rng() % cells.size()];
+        bfsExpanded += bfsDistanceField(graph, {to}, dist, from);
+        int step;
+        t0 = std::chrono::steady_clock::now();
+        bool found = junctionNextStep(junctions, from, to, step);
+        junctionMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        junctionSettled += lastSearchNodesTouched;
+        // The BFS stopped at `from`, so every cell one step closer to `to` already has its distance.
+        bool ok = (found == (dist[from] != -1)) && (!found || from == to || dist[step] == dist[from] - 1);
+        if (!ok) wrongSteps++;
+    }
+    std::cout << "Junction graph: " << junctions.nodeCells.size() << " nodes for " << cells.size() << " path cells ("
+              << (double)cells.size() / std::max<size_t>(1, junctions.nodeCells.size()) << "x fewer), built in " << buildMs << " ms\n";
+    std::cout << "  BFS expanded per query:       " << (double)bfsExpanded / queries << "\n";
+    std::cout << "  Junction settled per query:   " << (double)junctionSettled / queries << "  (" << junctionMs / queries
+              << " ms per query, " << wrongSteps << " first steps off a shortest path)\n";
+}
+
+/**
+ * @brief Compares single-query expansions of the stateless pathfinders on the built-in layouts.
+ */
+void benchBuiltInLayouts(std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<int> cells;
+        for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+        const int queries = 5000;
+        long long bfs = 0, junction = 0, bidirectional = 0;
+        for (int q = 0; q < queries; ++q) {
+            int from = cells[rng() % cells.size()], to = cells[rng() % cells.size()];
+            int stepX, stepY, step;
+            bfsNextStep(from % COLS, from / COLS, to % COLS, to / COLS, stepX, stepY);
+            bfs += lastSearchNodesTouched;
+            junctionNextStep(levelJunctions, from, to, step);
+            junction += lastSearchNodesTouched;
+            bidirectionalNextStep(mazeGraph, from, to, step);
+            bidirectional += lastSearchNodesTouched;
+        }
+        std::cout << "Level " << level << " (" << levelJunctions.nodeCells.size() << " junctions, " << levelJunctions.edges.size()
+                  << " edges) expansions per query: BFS " << (double)bfs / queries << ", junction graph "
+                  << (double)junction / queries << ", bidirectional BFS " << (double)bidirectional / queries << "\n";
+    }
+}
+
+/**
+ * @brief Toggles random tiles with setTile() on every built-in layout and checks the patched
+ * maze graph against a full compile and the patched junction graph against BFS.
+ */
+void benchSetTile(int toggles, std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        double patchMs = 0.0, fullMs = 0.0;
+        int graphMismatches = 0, junctionMismatches = 0;
+        MazeGraph fresh;
+        std::vector<int> dist;
+        for (int t = 0; t < toggles; ++t) {
+            int x = 1 + rng() % (COLS - 2), y = 1 + rng() % (ROWS - 2);
+            maze[y][x] = (maze[y][x] == TILE_PATH) ? TILE_BLOCKED : TILE_PATH;
+            std::vector<int> changed = {y * COLS + x};
+            auto t0 = std::chrono::steady_clock::now();
+            patchMazeGraph(mazeGraph, &maze[0][0], levelPortals, changed);
+            patchJunctionGraph(levelJunctions, changed);
+            auto t1 = std::chrono::steady_clock::now();
+            compileMazeGraph(fresh, &maze[0][0], COLS, ROWS, levelPortals);
+            auto t2 = std::chrono::steady_clock::now();
+            patchMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            fullMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            if (fresh.offsets != mazeGraph.offsets || fresh.targets != mazeGraph.targets || fresh.moves != mazeGraph.moves || fresh.walkable != mazeGraph.walkable) graphMismatches++;
+
+            // Every first step the junction graph picks must lie on a shortest path.
+            std::vector<int> cells;
+            for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+            for (int q = 0; q < 8 && !cells.empty(); ++q) {
+                int from = cells[rng() % cells.size()], to = cells[rng() % cells.size()];
+                bfsDistanceField(mazeGraph, {to}, dist, -1);
+                int step;
+                bool found = junctionNextStep(levelJunctions, from, to, step);
+                bool ok = (found == (dist[from] != -1)) && (!found || from == to || dist[step] == dist[from] - 1);
+                if (!ok) junctionMismatches++;
+            }
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        buildJunctionGraph(levelJunctions, mazeGraph);
+        double junctionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "setTile, level " << level << ": graph patch " << patchMs * 1000.0 / toggles << " us vs compile "
+                  << fullMs * 1000.0 / toggles << " us + junction build " << junctionMs * 1000.0 << " us, "
+                  << graphMismatches << " graph and " << junctionMismatches << " junction mismatches\n";
+    }
+}
+
+/**
+ * @brief Runs the predictive AI on every built-in layout at the fastest cat speed
+ * and reports how close the search comes to its budget and to the tick deadline.
+ */
+void benchPredictive(std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<int> cells;
+        for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+        int budget = std::min(PREDICTIVE_MAX_BUDGET_MS, (int)(MIN_CAT_DELAY_MS * PREDICTIVE_BUDGET_FRACTION));
+        double worstMs = 0.0;
+        long long depthSum = 0, nodeSum = 0, hitSum = 0;
+        const int queries = 50;
+        for (int q = 0; q < queries; ++q) {
+            int cat = cells[rng() % cells.size()], player = cells[rng() % cells.size()], step, depth;
+            auto t0 = std::chrono::steady_clock::now();
+            predictiveNextStep(cat, player, budget, step, depth);
+            worstMs = std::max(worstMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+            depthSum += depth;
+            nodeSum += lastSearchNodesTouched;
+            hitSum += lastSearchTableHits;
+        }
+        std::cout << "Predictive AI, level " << level << ": average depth " << (double)depthSum / queries << ", worst "
+                  << worstMs << " ms (budget " << budget << " ms, tick " << MIN_CAT_DELAY_MS << " ms), "
+                  << (nodeSum ? 100.0 * hitSum / nodeSum : 0.0) << "% transposition hits\n";
+    }
+
+    // Window play: the game thread only picks up the planned move and starts the next search.
+    initMaze(1);
+    int budget = std::min(PREDICTIVE_MAX_BUDGET_MS, (int)(MIN_CAT_DELAY_MS * PREDICTIVE_BUDGET_FRACTION));
+    int cat = CAT_START_Y * COLS + CAT_START_X, player = PLAYER_START_Y * COLS + PLAYER_START_X, planned = 0;
+    double worstMs = 0.0;
+    const int ticks = 40;
+    for (int tick = 0; tick < ticks; ++tick) {
+        player = mazeGraph.moves[player * 4 + rng() % 4];
+        int step;
+        bool fromPlan = predictivePlanned.cat == cat;
+        auto t0 = std::chrono::steady_clock::now();
+        predictiveBackgroundStep(cat, player, budget, step);
+        worstMs = std::max(worstMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        planned += fromPlan;
+        cat = (step == -1 || step == player) ? CAT_START_Y * COLS + CAT_START_X : step;
+        std::this_thread::sleep_for(std::chrono::milliseconds(budget + 2)); // The rest of the cat's tick.
+    }
+    discardPredictiveSearch();
+    std::cout << "Predictive AI in the background: worst " << worstMs << " ms on the game thread per cat move, "
+              << planned << "/" << ticks << " moves planned a tick ahead\n";
+}
+
+/**
+ * @brief Compares D* Lite against a from-scratch BFS every tick on the built-in layouts.
+ * The player random-walks, the cat chases, and every 25 ticks a door closes on a random
+ * corridor cell while the previous one reopens.
+ */
+void benchDStar(int ticks, std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        int player = PLAYER_START_Y * COLS + PLAYER_START_X;
+        int cat = CAT_START_Y * COLS + CAT_START_X;
+        dstarInit(catDStar, mazeGraph, levelPortals, cat, player);
+        long long bfsExpanded = 0, dstarExpanded = 0;
+        int optimal = 0, measured = 0, door = -1;
+        std::vector<int> dist;
+        for (int tick = 0; tick < ticks; ++tick) {
+            if (tick % 25 == 24) {
+                if (door != -1) setTile(door % COLS, door / COLS, TILE_PATH);
+                int candidate = rng() % (ROWS * COLS);
+                bool corridor = mazeGraph.walkable[candidate] && mazeGraph.offsets[candidate + 1] - mazeGraph.offsets[candidate] == 2;
+                door = (corridor && candidate != player && candidate != cat) ? candidate : -1;
+                if (door != -1) setTile(door % COLS, door / COLS, TILE_BLOCKED);
+            }
+            int dir = rng() % 4;
+            player = mazeGraph.moves[player * 4 + dir];
+
+            int stepX, stepY, step;
+            bfsNextStep(cat % COLS, cat / COLS, player % COLS, player / COLS, stepX, stepY);
+            bfsExpanded += lastSearchNodesTouched;
+            bool found = dstarNextStep(catDStar, cat, player, step);
+            dstarExpanded += lastSearchNodesTouched;
+            if (found && step != -1) {
+                bfsDistanceField(mazeGraph, {player}, dist, -1);
+                measured++;
+                if (dist[step] == dist[cat] - 1) optimal++;
+                cat = step;
+            }
+            if (cat == player) cat = CAT_START_Y * COLS + CAT_START_X; // Respawn and keep chasing.
+        }
+        if (door != -1) setTile(door % COLS, door / COLS, TILE_PATH);
+        std::cout << "D* Lite, level " << level << ": " << (double)dstarExpanded / ticks << " expansions per tick vs BFS "
+                  << (double)bfsExpanded / ticks << " (optimal steps " << optimal << "/" << measured << ")\n";
+    }
+}
+
+/**
+ * @brief Times a full chaser tick (main cat plus ambushers) for growing ambusher counts.
+ * The player random-walks; everyone goes back to the start whenever a chaser catches them.
+ */
+void benchAmbushers(int ticks, std::mt19937& rng) {
+    const ChaserPersonality cycle[] = {PERSONALITY_INTERCEPTOR, PERSONALITY_FLANKER, PERSONALITY_PATROLLER};
+    engineLog = false; // Every level start and capture would log.
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        currentLevel = level;
+        std::stringstream report;
+        report << "Ambushers, level " << level << ":";
+        for (int count = 0; count <= MAX_AMBUSHERS; ++count) {
+            ambusherPersonalities.clear();
+            for (int i = 0; i < count; ++i) ambusherPersonalities.push_back(cycle[i % 3]);
+            initLevelData();
+            int captures = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int tick = 0; tick < ticks; ++tick) {
+                int player = mazeGraph.moves[(playerY * COLS + playerX) * 4 + rng() % 4];
+                playerX = player % COLS;
+                playerY = player / COLS;
+                moveCat();
+                bool caught = (catX == playerX && catY == playerY);
+                for (const auto& a : ambushers) caught = caught || (a.x == playerX && a.y == playerY);
+                if (caught) {
+                    captures++;
+                    playerX = PLAYER_START_X;
+                    playerY = PLAYER_START_Y;
+                    catX = CAT_START_X;
+                    catY = CAT_START_Y;
+                    for (auto& a : ambushers) { a.x = CAT_START_X; a.y = CAT_START_Y; }
+                }
+            }
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / ticks;
+            report << " " << count << " -> " << us << " us/tick (" << captures << " captures)";
+        }
+        std::cout << report.str() << "\n";
+    }
+    engineLog = true;
+    ambusherPersonalities.clear();
+}
+
+/**
+ * @brief Times snapshot/restore pairs and checks that a restored game replays to the
+ * exact same state when fed the same moves.
+ */
+void benchSnapshot(int ticks, std::mt19937& rng) {
+    ambusherPersonalities = {PERSONALITY_INTERCEPTOR, PERSONALITY_WATCHER};
+    engineLog = false; // Level starts and captures all log.
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        currentLevel = level;
+        initLevelData();
+        currentGameState = PLAYING;
+        GameSnapshot start, first;
+        snapshotGame(start);
+        unsigned moveSeed = rng();
+        auto play = [&]() {
+            std::mt19937 moves(moveSeed);
+            for (int tick = 0; tick < ticks; ++tick) {
+                int player = mazeGraph.moves[(playerY * COLS + playerX) * 4 + moves() % 4];
+                playerX = player % COLS;
+                playerY = player / COLS;
+                moveCat();
+            }
+        };
+        play();
+        snapshotGame(first);
+        restoreGame(start);
+        play();
+        bool identical = std::memcmp(&first, &liveGame, sizeof(GameSnapshot)) == 0;
+
+        const int copies = 100000;
+        GameSnapshot scratch;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < copies; ++i) {
+            snapshotGame(scratch);
+            std::memcpy(&liveGame, &scratch, sizeof(GameSnapshot));
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / copies;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 1000; ++i) restoreGame(start);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / 1000;
+        std::cout << "Snapshot, level " << level << ": " << sizeof(GameSnapshot) << " bytes, copy pair " << ns
+                  << " ns, full restore " << us << " us, replay " << (identical ? "identical" : "DIVERGED") << "\n";
+    }
+    engineLog = true;
+    ambusherPersonalities.clear();
+}
+
+/**
+ * @brief Plays a headless bot session of `events` events, recording it to `path`.
+ * The bot heads for the nearest cheese it can reach without stepping next to a chaser,
+ * with the odd random step, and starts a new
+ * game or the next level whenever one ends.
+ * @param states If given, receives the state after each event (index 0 is the start).
+ */
+bool recordBotSession(const std::string& path, int events, std::mt19937& rng, std::vector<GameSnapshot>* states) {
+    ReplayWriter writer;
+    if (!replayBeginRecording(writer, path)) return false;
+    currentGameState = GAME_OVER;
+    if (states != nullptr) states->push_back(liveGame);
+    auto emit = [&](ReplayEvent event) {
+        replayAppend(writer, event);
+        applyReplayEvent(event);
+        if (states != nullptr) states->push_back(liveGame);
+    };
+    for (int tick = 0; tick < events; ++tick) {
+        if (currentGameState == GAME_OVER || currentGameState == GAME_WON_FINAL) { emit({REPLAY_NEW_GAME, 0, 0}); continue; }
+        if (currentGameState == GAME_WON_LEVEL) { emit({REPLAY_START_LEVEL, (uint8_t)currentLevel, 0}); continue; }
+        if (isCatSlowed) { emit({REPLAY_SLOW_TIMER, 0, 16}); continue; }
+        if (tick % 3 == 0) { emit({REPLAY_CAT_MOVE, catStepDirection(catNextStep()), 0}); continue; } // The player is quicker than the cat.
+        int cell = playerY * COLS + playerX, bestDir = rng() % 4, bestDistance = INT_MAX;
+        ensureLevelDistances();
+        if (rng() % 4 != 0) {
+            for (int dir = 0; dir < 4; ++dir) {
+                int next = mazeGraph.moves[cell * 4 + dir];
+                bool risky = levelDistance(next, catY * COLS + catX) <= 1;
+                for (const auto& a : ambushers) risky = risky || levelDistance(next, a.y * COLS + a.x) <= 1;
+                if (risky) continue; // Keeps a step away from every chaser.
+                for (const auto& loc : cheeseLocations) {
+                    int d = levelDistance(next, loc.y * COLS + loc.x);
+                    if (d < bestDistance) { bestDistance = d; bestDir = dir; }
+                }
+            }
+        }
+        emit({REPLAY_PLAYER_MOVE, (uint8_t)bestDir, 0});
+    }
+    replayFinishRecording(writer);
+    return true;
+}
+
+/**
+ * @brief Records a long bot session, then times random seeks in the mapped file and
+ * checks each against the state reached while recording.
+ */
+void benchReplaySeek(int events, int seeks, std::mt19937& rng) {
+    const char* path = "bench.replay";
+    ambusherPersonalities = {PERSONALITY_INTERCEPTOR};
+    std::vector<GameSnapshot> states;
+    states.reserve(events + 1);
+    engineLog = false; // Pickups, captures and level loads all log.
+    if (!recordBotSession(path, events, rng, &states)) { engineLog = true; std::cout << "Replay seek: cannot write " << path << "\n"; return; }
+
+    ReplayReader reader;
+    bool opened = openReplay(reader, path);
+    double totalMs = 0.0, worstMs = 0.0;
+    int mismatches = 0;
+    for (int i = 0; opened && i < seeks; ++i) {
+        uint64_t tick = rng() % (events + 1);
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t reached = seekReplay(reader, tick);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        totalMs += ms;
+        worstMs = std::max(worstMs, ms);
+        if (reached != tick || std::memcmp(&states[tick], &liveGame, sizeof(GameSnapshot)) != 0) mismatches++;
+    }
+    engineLog = true;
+    if (!opened) { std::cout << "Replay seek: could not reopen " << path << "\n"; return; }
+    std::cout << "Replay seek: " << events << " events, " << reader.index.size() << " keyframes, " << reader.size / 1024 << " KiB; "
+              << seeks << " seeks average " << totalMs / seeks << " ms, worst " << worstMs << " ms, " << mismatches << " mismatches\n";
+    closeReplay(reader);
+    std::remove(path);
+    ambusherPersonalities.clear();
+}
+
+/**
+ * @brief Times incremental batched observation encoding against full re-encodes, with
+ * environments spread along a recorded bot trajectory, and checks they agree.
+ */
+void benchObservation(int envs, int steps, std::mt19937& rng) {
+    const char* path = "bench.replay";
+    ambusherPersonalities = {PERSONALITY_FLANKER, PERSONALITY_WATCHER};
+    std::vector<GameSnapshot> trajectory;
+    engineLog = false;
+    bool recorded = recordBotSession(path, 4000, rng, &trajectory);
+    engineLog = true;
+    std::remove(path);
+    ambusherPersonalities.clear();
+    if (!recorded) return;
+
+    std::vector<GameSnapshot> batch(envs);
+    std::vector<uint8_t> incremental((size_t)envs * OBSERVATION_SIZE), full((size_t)envs * OBSERVATION_SIZE);
+    std::vector<ObservationEncoder> encoders(envs), scratch(envs);
+    double incrementalNs = 0.0, fullNs = 0.0;
+    int mismatches = 0;
+    for (int step = 0; step < steps; ++step) {
+        for (int i = 0; i < envs; ++i) batch[i] = trajectory[(step + 61 * i) % trajectory.size()];
+        auto t0 = std::chrono::steady_clock::now();
+        encodeObservationBatch(batch.data(), envs, incremental.data(), encoders.data());
+        auto t1 = std::chrono::steady_clock::now();
+        for (auto& e : scratch) e.buffer = nullptr; // Forces a full write every step.
+        encodeObservationBatch(batch.data(), envs, full.data(), scratch.data());
+        auto t2 = std::chrono::steady_clock::now();
+        incrementalNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        fullNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        if (incremental != full) mismatches++;
+    }
+    double perEnv = 1.0 / ((double)envs * steps);
+    std::cout << "Observation encoder: " << OBSERVATION_SIZE << " bytes per env, " << envs << " envs x " << steps << " steps: incremental "
+              << incrementalNs * perEnv << " ns/env, full " << fullNs * perEnv << " ns/env, " << mismatches << " mismatched steps\n";
+}
+
+/**
+ * @brief Times a danger-map refresh plus a safe-route search on the built-in layouts,
+ * with five chasers and the player placed at random.
+ */
+void benchSafeRoute(int queries, std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<int> cells, sources, goals, field, route;
+        for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+        double fieldUs = 0.0, routeUs = 0.0, worstUs = 0.0;
+        for (int q = 0; q < queries; ++q) {
+            sources.clear();
+            goals.clear();
+            for (int i = 0; i < 5; ++i) sources.push_back(cells[rng() % cells.size()]);
+            for (int i = 0; i < NUM_CHEESE_TO_PLACE; ++i) goals.push_back(cells[rng() % cells.size()]);
+            auto t0 = std::chrono::steady_clock::now();
+            bfsDistanceField(mazeGraph, sources, field, -1);
+            auto t1 = std::chrono::steady_clock::now();
+            safestRoute(mazeGraph, field, cells[rng() % cells.size()], goals, route);
+            auto t2 = std::chrono::steady_clock::now();
+            fieldUs += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            routeUs += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            worstUs = std::max(worstUs, std::chrono::duration<double, std::micro>(t2 - t0).count());
+        }
+        std::cout << "Safe route, level " << level << ": danger map " << fieldUs / queries << " us, route " << routeUs / queries
+                  << " us, worst total " << worstUs << " us\n";
+    }
+
+    // Brute force: lower the safety threshold until some cheese is reachable through cells at
+    // least that safe; the first such threshold is the bottleneck, the nearest cheese the length.
+    int cases = 0, mismatches = 0;
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<int> cells, sources, goals, field, route, dist;
+        for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+        for (int q = 0; q < 3000; ++q, ++cases) {
+            sources.clear();
+            goals.clear();
+            for (int i = 1 + rng() % 5; i > 0; --i) sources.push_back(cells[rng() % cells.size()]);
+            for (int i = 1 + rng() % NUM_CHEESE_TO_PLACE; i > 0; --i) goals.push_back(cells[rng() % cells.size()]);
+            int start = cells[rng() % cells.size()];
+            bfsDistanceField(mazeGraph, sources, field, -1);
+            int bottleneck = safestRoute(mazeGraph, field, start, goals, route);
+            int unreached = *std::max_element(field.begin(), field.end()) + 1;
+            auto safety = [&](int c) { return field[c] < 0 ? unreached : field[c]; };
+            int expectBottleneck = -1, expectLength = -1;
+            for (int threshold = unreached; threshold >= 0 && expectBottleneck == -1; --threshold) {
+                dist.assign(ROWS * COLS, -1);
+                std::vector<int> queue = {start};
+                dist[start] = 0;
+                for (size_t head = 0; head < queue.size() && expectBottleneck == -1; ++head) {
+                    int cell = queue[head];
+                    for (int i = mazeGraph.offsets[cell]; i < mazeGraph.offsets[cell + 1]; ++i) {
+                        int next = mazeGraph.targets[i];
+                        if (dist[next] != -1 || safety(next) < threshold) continue;
+                        dist[next] = dist[cell] + 1;
+                        queue.push_back(next);
+                        if (std::find(goals.begin(), goals.end(), next) != goals.end()) {
+                            expectBottleneck = threshold;
+                            expectLength = dist[next];
+                            break;
+                        }
+                    }
+                }
+            }
+            bool ok = bottleneck == expectBottleneck && (expectLength == -1 ? route.empty() : (int)route.size() == expectLength);
+            for (size_t i = 0; ok && i < route.size(); ++i) {
+                int from = (i == 0) ? start : route[i - 1];
+                bool adjacent = false;
+                for (int k = mazeGraph.offsets[from]; k < mazeGraph.offsets[from + 1]; ++k) adjacent = adjacent || mazeGraph.targets[k] == route[i];
+                ok = adjacent && safety(route[i]) >= bottleneck;
+            }
+            if (ok && !route.empty()) ok = std::find(goals.begin(), goals.end(), route.back()) != goals.end();
+            mismatches += !ok;
+        }
+    }
+    std::cout << "Safe route vs brute force: " << mismatches << " mismatches in " << cases << " cases\n";
+}
+
+/**
+ * @brief Times vision checks for a crowd of chasers against walking each line of sight,
+ * and checks that both agree.
+ */
+void benchVision(int chasers, int ticks, std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::vector<int> cells, crowd;
+        for (int cell = 0; cell < ROWS * COLS; ++cell) if (mazeGraph.walkable[cell]) cells.push_back(cell);
+        for (int i = 0; i < chasers; ++i) crowd.push_back(cells[rng() % cells.size()]);
+        std::vector<int> players;
+        for (int tick = 0; tick < ticks; ++tick) players.push_back(cells[rng() % cells.size()]);
+
+        long long bitsetSeen = 0, raySeen = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int player : players) for (int c : crowd) bitsetSeen += canSee(c, player);
+        auto t1 = std::chrono::steady_clock::now();
+        for (int player : players) {
+            for (int c : crowd) {
+                int dx = player % COLS - c % COLS, dy = player / COLS - c / COLS;
+                if (dx != 0 && dy != 0) continue;
+                int sx = (dx > 0) - (dx < 0), sy = (dy > 0) - (dy < 0);
+                int x = c % COLS, y = c / COLS;
+                while ((x != player % COLS || y != player / COLS) && mazeGraph.walkable[y * COLS + x]) { x += sx; y += sy; }
+                raySeen += mazeGraph.walkable[y * COLS + x];
+            }
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        double checks = (double)chasers * ticks;
+        std::cout << "Vision, level " << level << ": bitset " << std::chrono::duration<double, std::nano>(t1 - t0).count() / checks
+                  << " ns/check, raycast " << std::chrono::duration<double, std::nano>(t2 - t1).count() / checks << " ns/check ("
+                  << (bitsetSeen == raySeen ? "agree" : "MISMATCH") << ", " << bitsetSeen << " sightings)\n";
+    }
+}
+
+/**
+ * @brief Reports the chokepoints of the built-in layouts and checks them by brute force.
+ */
+void benchChokepoints(std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        std::cout << "Chokepoints, level " << level << ": " << levelArticulationCount << " articulation points, " << levelBridges.size() << " bridges\n";
+    }
+
+    // Brute force: a cell is an articulation point if removing it splits its component, an
+    // edge a bridge if removing it disconnects its ends. Walls are added at random so that
+    // some variants split into several components.
+    int variants = 0, mismatches = 0;
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        for (int variant = 0; variant < 20; ++variant, ++variants) {
+            initMaze(level);
+            for (int wall = 0; wall < variant; ++wall) {
+                int cell = rng() % (ROWS * COLS);
+                if (mazeGraph.walkable[cell]) setTile(cell % COLS, cell / COLS, TILE_BLOCKED);
+            }
+            auto components = [&](int removedCell, int removedA, int removedB) {
+                std::vector<int> seen(ROWS * COLS, 0), queue;
+                int count = 0;
+                for (int start = 0; start < ROWS * COLS; ++start) {
+                    if (!mazeGraph.walkable[start] || start == removedCell || seen[start]) continue;
+                    count++;
+                    seen[start] = 1;
+                    queue.assign(1, start);
+                    for (size_t head = 0; head < queue.size(); ++head) {
+                        int cell = queue[head];
+                        for (int i = mazeGraph.offsets[cell]; i < mazeGraph.offsets[cell + 1]; ++i) {
+                            int next = mazeGraph.targets[i];
+                            if (next == removedCell || seen[next]) continue;
+                            if ((cell == removedA && next == removedB) || (cell == removedB && next == removedA)) continue;
+                            seen[next] = 1;
+                            queue.push_back(next);
+                        }
+                    }
+                }
+                return count;
+            };
+            int whole = components(-1, -1, -1);
+            std::vector<bool> isGate(ROWS * COLS, false);
+            for (int cell = 0; cell < ROWS * COLS; ++cell) if (levelPocketGate[cell] != -1) isGate[levelPocketGate[cell]] = true;
+            int articulation = 0;
+            for (int cell = 0; cell < ROWS * COLS; ++cell) {
+                if (!mazeGraph.walkable[cell]) continue;
+                bool isolated = mazeGraph.offsets[cell + 1] == mazeGraph.offsets[cell];
+                bool expected = !isolated && components(cell, -1, -1) > whole;
+                articulation += expected;
+                if (expected != isGate[cell]) mismatches++;
+            }
+            if (articulation != levelArticulationCount) mismatches++;
+            std::vector<std::pair<int, int>> bridges;
+            for (const auto& b : levelBridges) bridges.push_back({std::min(b.first, b.second), std::max(b.first, b.second)});
+            std::sort(bridges.begin(), bridges.end());
+            for (int cell = 0; cell < ROWS * COLS; ++cell) {
+                for (int i = mazeGraph.offsets[cell]; i < mazeGraph.offsets[cell + 1]; ++i) {
+                    int next = mazeGraph.targets[i];
+                    if (next < cell) continue;
+                    bool expected = components(-1, cell, next) > whole;
+                    if (expected != std::binary_search(bridges.begin(), bridges.end(), std::make_pair(cell, next))) mismatches++;
+                }
+            }
+        }
+    }
+    initMaze(1);
+    std::cout << "Chokepoints vs brute force: " << mismatches << " mismatches in " << variants << " layouts\n";
+}
+
+/**
+ * @brief Plays one level the bot's way through the engine itself: advanceGameClock() moves the
+ * cat and ends slowdowns, applyPlayerMove() takes the bot's steps. The level must be started.
+ */
+SimResult simulateOnEngine(const SimBot& bot, std::mt19937& rng) {
+    SimResult result;
+    int now = 0, nextInput = bot.inputIntervalMs;
+    while (currentGameState == PLAYING) {
+        // Step exactly to the next thing that happens so no event is folded into another.
+        int next = std::min(nextInput, now + std::max(0, liveGame.catCountdownMs));
+        if (isCatSlowed) next = std::min(next, now + std::max(0, catSlowDurationTimer));
+        if (next > SIM_TIME_LIMIT_MS) break;
+        advanceGameClock(next - now);
+        now = next;
+        if (currentGameState != PLAYING || now != nextInput) continue;
+        SimGame view;
+        simCaptureLiveGame(view);
+        int cell = view.player, step = simBotMove(view, bot, rng);
+        for (int dir = 0; dir < 4 && step != cell; ++dir) {
+            if (mazeGraph.moves[cell * 4 + dir] == step) {
+                applyPlayerMove((Direction)dir);
+                break;
+            }
+        }
+        nextInput += bot.inputIntervalMs;
+    }
+    result.won = (currentGameState == GAME_WON_LEVEL || currentGameState == GAME_WON_FINAL);
+    result.caught = (currentGameState == GAME_OVER);
+    result.timeMs = now;
+    result.score = totalScore + score;
+    return result;
+}
+
+/**
+ * @brief Simulates whole bot-played levels on each built-in layout and reports their cost.
+ */
+void benchSimulator(int games, std::mt19937& rng) {
+    SimBot bot;
+    CatSpeedCurve curve;
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        ensureLevelDistances();
+        int wins = 0;
+        long long events = 0;
+        double simulatedMs = 0.0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int game = 0; game < games; ++game) {
+            SimResult result = simulateLevel(bot, curve, rng);
+            wins += result.won;
+            events += result.events;
+            simulatedMs += result.timeMs;
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / games;
+
+        // Replay games from the same start through the engine; the copied rules must match it move for move.
+        CatPathfinder savedPathfinder = catPathfinder;
+        catPathfinder = PATHFINDER_BFS;
+        int checked = games / 20, differ = 0;
+        engineLog = false; // Pickups, captures and level ends all log.
+        for (int game = 0; game < checked; ++game) {
+            currentLevel = level;
+            totalScore = 0;
+            initLevelData();
+            currentGameState = PLAYING;
+            SimGame start;
+            simCaptureLiveGame(start);
+            unsigned seed = rng();
+            std::mt19937 simRng(seed), engineRng(seed);
+            SimResult expected = simulateGame(start, bot, currentSpeedCurve(), simRng);
+            SimResult actual = simulateOnEngine(bot, engineRng);
+            differ += expected.won != actual.won || expected.caught != actual.caught || expected.score != actual.score || expected.timeMs != actual.timeMs;
+        }
+        engineLog = true;
+        catPathfinder = savedPathfinder;
+        std::cout << "Simulator, level " << level << ": " << us << " us per game, " << (double)events / games << " events, "
+                  << simulatedMs / games / 1000.0 << " s of play, bot won " << wins << "/" << games
+                  << ", " << differ << "/" << checked << " games differ from the engine\n";
+    }
+}
+
+/**
+ * @brief Compares the optimized item placement with plain random placements.
+ */
+void benchPlacement(std::mt19937& rng) {
+    for (int level = 1; level <= MAX_LEVELS; ++level) {
+        initMaze(level);
+        ensureLevelDistances();
+        ItemPlacement candidate;
+        float randomSum = 0.0f, randomWorst = 1e30f;
+        const int samples = 1000;
+        for (int i = 0; i < samples; ++i) {
+            randomPlacement(candidate, rng);
+            float score = scorePlacement(candidate);
+            randomSum += score;
+            randomWorst = std::min(randomWorst, score);
+        }
+        cheeseLocations.clear();
+        powerupLocations.clear();
+        uint32_t seed = liveGame.randomState;
+        auto t0 = std::chrono::steady_clock::now();
+        placeItemsOptimized();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        // The same seed must give the same items, or versus peers would start on different levels.
+        auto firstCheese = cheeseLocations;
+        cheeseLocations.clear();
+        powerupLocations.clear();
+        liveGame.randomState = seed;
+        placeItemsOptimized();
+        bool repeatable = cheeseLocations.size() == firstCheese.size()
+                       && std::equal(firstCheese.begin(), firstCheese.end(), cheeseLocations.begin(),
+                                     [](const GridPoint& a, const GridPoint& b) { return a.x == b.x && a.y == b.y; });
+        std::cout << "Placement, level " << level << ": random average " << randomSum / samples << " (worst " << randomWorst
+                  << "), optimized " << lastPlacementScore << " as best of " << lastPlacementCandidates << " candidates in "
+                  << ms << " ms, " << (repeatable ? "same" : "DIFFERENT") << " items on a rerun\n";
+        cheeseLocations.clear();
+        powerupLocations.clear();
+    }
+    cheeseLocations.clear();
+    powerupLocations.clear();
+}
+
+/**
+ * @brief Times the parallel BFS against the serial one on a maze and checks both fields match.
+ */
+void benchParallelBfs(const MazeGraph& graph, const std::vector<int>& cells, const char* label) {
+    WorkerPool pool;
+    poolStart(pool, 0);
+    std::vector<int> serial, parallel;
+    int source = cells[cells.size() / 2];
+    auto t0 = std::chrono::steady_clock::now();
+    bfsDistanceField(graph, {source}, serial, -1);
+    auto t1 = std::chrono::steady_clock::now();
+    int levels = parallelBfsDistanceField(pool, graph, source, parallel);
+    auto t2 = std::chrono::steady_clock::now();
+    std::vector<int> sources;
+    for (int i = 0; i < 8; ++i) sources.push_back(cells[(cells.size() / 8) * i]);
+    std::vector<std::vector<int>> fields;
+    parallelDistanceFields(pool, graph, sources, fields);
+    auto t3 = std::chrono::steady_clock::now();
+    std::vector<int> check;
+    bfsDistanceField(graph, {sources[0]}, check, -1);
+    bool match = (serial == parallel) && (check == fields[0]);
+    std::cout << "Parallel BFS (" << label << ", " << poolSize(pool) << " workers, " << levels << " levels): serial "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms, parallel "
+              << std::chrono::duration<double, std::milli>(t2 - t1).count() << " ms, 8 batched fields "
+              << std::chrono::duration<double, std::milli>(t3 - t2).count() << " ms, fields "
+              << (match ? "match" : "DIFFER") << "\n";
+    poolStop(pool);
+}
+
+/**
+ * @brief Headless entry point: main --bench [size] [queries].
+ * Generates a size x size maze and reports how the pathfinders compare on it.
+ */
+int runBenchmarks(int argc, char** argv) {
+    int size = (argc > 2) ? std::max(7, atoi(argv[2])) | 1 : 1023;
+    int queries = (argc > 3) ? std::max(1, atoi(argv[3])) : 20;
+    std::mt19937 rng(12345);
+    std::vector<int> tiles;
+    generateMaze(tiles, size, size, 12345, 0.05);
+    MazeGraph graph;
+    compileMazeGraph(graph, tiles.data(), size, size, {});
+    std::vector<int> cells;
+    for (int cell = 0; cell < size * size; ++cell) if (graph.walkable[cell]) cells.push_back(cell);
+    std::cout << "Generated " << size << "x" << size << " maze with " << cells.size() << " path cells.\n";
+
+    benchHpa(graph, cells, queries, rng);
+    benchJunctionGraph(graph, cells, queries, rng);
+    benchParallelBfs(graph, cells, "braided");
+
+    // A mostly open maze has wide frontiers, which is where bottom-up sweeps pay off.
+    std::vector<int> openTiles;
+    generateMaze(openTiles, size, size, 12345, 0.6);
+    MazeGraph openGraph;
+    compileMazeGraph(openGraph, openTiles.data(), size, size, {});
+    std::vector<int> openCells;
+    for (int cell = 0; cell < size * size; ++cell) if (openGraph.walkable[cell]) openCells.push_back(cell);
+    benchParallelBfs(openGraph, openCells, "open");
+    benchBuiltInLayouts(rng);
+    benchDStar(2000, rng);
+    benchSetTile(2000, rng);
+    benchPredictive(rng);
+    benchAmbushers(2000, rng);
+    benchSnapshot(500, rng);
+    benchReplaySeek(60000, 1000, rng);
+    benchObservation(64, 2000, rng);
+    benchSafeRoute(1000, rng);
+    benchVision(256, 2000, rng);
+    benchChokepoints(rng);
+    benchSimulator(10000, rng);
+    benchPlacement(rng);
+    benchStateDeltas(60000, rng);
+    benchRollback(20000, rng);
+    return 0;
+}
+
+
+// -----------------------------------------------------------------------------
+// C INTERFACE (libchase.so, see chase.h)
+// -----------------------------------------------------------------------------
+
+// A caller-owned instance: the game state plus what is needed to load it into the engine.
+// The engine runs on the globals above, so each call copies the instance in, runs, and
+// copies it back out, all under chaseMutex. The copies are a few hundred bytes; switching
+// between instances on different levels also reloads the layout, which chase_step_batch
+// avoids by grouping instances by level.
+const uint32_t CHASE_INSTANCE_MAGIC = 0x49534843; // "CHSI"
+
+struct ChaseInstance {
+    uint32_t magic;
+    uint32_t snapshotSize; // Catches buffers from a build with a different GameSnapshot.
+    chase_config config;
+    GameSnapshot game;
+    ObservationEncoder encoder;
+};
+static_assert(std::is_trivially_copyable<ChaseInstance>::value, "instances are copied with memcpy");
+
+std::mutex chaseMutex;
+std::once_flag chaseInitOnce;
+
+ChaseInstance* chaseInstance(void* state) {
+    ChaseInstance* instance = static_cast<ChaseInstance*>(state);
+    if (instance == nullptr || instance->magic != CHASE_INSTANCE_MAGIC || instance->snapshotSize != sizeof(GameSnapshot)) return nullptr;
+    return instance;
+}
+
+/**
+ * @brief Points the engine's configuration globals at an instance's settings.
+ */
+void chaseApplyConfig(const chase_config& config) {
+    catPathfinder = (CatPathfinder)config.pathfinder;
+    ambusherPersonalities.clear();
+    for (int i = 0; i < config.ambusher_count; ++i) ambusherPersonalities.push_back((ChaserPersonality)config.ambushers[i]);
+}
+
+bool chaseValidConfig(const chase_config& config) {
+    if (config.level < 1 || config.level > MAX_LEVELS) return false;
+    if (config.pathfinder < PATHFINDER_BFS || config.pathfinder > PATHFINDER_TABLEBASE) return false;
+    if (config.ambusher_count < 0 || config.ambusher_count > MAX_AMBUSHERS) return false;
+    for (int i = 0; i < config.ambusher_count; ++i) {
+        if (config.ambushers[i] < 0 || config.ambushers[i] >= PERSONALITY_COUNT) return false;
+    }
+    return true;
+}
+
+void chaseNewGame(ChaseInstance& instance, uint32_t seed) {
+    chaseApplyConfig(instance.config);
+    liveGame = GameSnapshot();
+    liveGame.randomState = seed != 0 ? seed : GameSnapshot().randomState;
+    startLevel(instance.config.level);
+    instance.game = liveGame;
+    instance.encoder.buffer = nullptr;
+}
+
+/**
+ * @brief Advances the game clock like catTimer() and idle() do in the window: the cat moves
+ * whenever its delay has elapsed (and skips its moves while slowed), and the slowdown runs down.
+ */
+void advanceGameClock(int elapsedMs) {
+    if (isCatSlowed) advanceSlowdownTimer(elapsedMs);
+    liveGame.catCountdownMs -= elapsedMs;
+    while (liveGame.catCountdownMs <= 0 && currentGameState == PLAYING) {
+        if (!isCatSlowed) moveCat();
+        liveGame.catCountdownMs += currentCatDelay;
+    }
+}
+
+int chaseStatus() {
+    if (currentGameState == GAME_OVER) return CHASE_STATUS_CAUGHT;
+    if (currentGameState == GAME_WON_FINAL) return CHASE_STATUS_WON;
+    return CHASE_STATUS_PLAYING;
+}
+
+/**
+ * @brief One step of an instance that is already validated; the caller holds chaseMutex.
+ */
+void chaseStepLocked(ChaseInstance& instance, int action, int elapsedMs, chase_step_result& result) {
+    chaseApplyConfig(instance.config);
+    restoreGame(instance.game);
+    int collectedBefore = totalScore + score;
+    result.level_cleared = 0;
+    if (currentGameState == PLAYING) {
+        if (action >= CHASE_ACTION_UP && action <= CHASE_ACTION_RIGHT) applyPlayerMove((Direction)action);
+        if (currentGameState == GAME_WON_LEVEL) {
+            result.level_cleared = 1;
+            startLevel(currentLevel); // The window waits two seconds here; headless play does not.
+        } else if (currentGameState == GAME_WON_FINAL) {
+            result.level_cleared = 1;
+        }
+        if (currentGameState == PLAYING && elapsedMs > 0) advanceGameClock(elapsedMs);
+    }
+    result.cheese = totalScore + score - collectedBefore;
+    result.status = chaseStatus();
+    instance.game = liveGame;
+}
+
+extern "C" {
+
+int chase_api_version(void) { return CHASE_API_VERSION; }
+size_t chase_state_size(void) { return sizeof(ChaseInstance); }
+size_t chase_state_align(void) { return alignof(ChaseInstance); }
+size_t chase_observation_size(void) { return OBSERVATION_SIZE; }
+
+void chase_grid_size(int* rows, int* cols) {
+    if (rows != nullptr) *rows = ROWS;
+    if (cols != nullptr) *cols = COLS;
+}
+
+void chase_default_config(chase_config* config) {
+    if (config == nullptr) return;
+    *config = chase_config();
+    config->level = 1;
+    config->pathfinder = CHASE_PATHFINDER_JUNCTION;
+}
+
+int chase_create(void* state, const chase_config* config) {
+    if (state == nullptr) return CHASE_ERROR_INVALID_ARGUMENT;
+    chase_config settings;
+    chase_default_config(&settings);
+    if (config != nullptr) settings = *config;
+    if (!chaseValidConfig(settings)) return CHASE_ERROR_INVALID_ARGUMENT;
+    std::call_once(chaseInitOnce, initZobristKeys);
+    std::lock_guard<std::mutex> lock(chaseMutex);
+    engineLog = settings.verbose;
+    ChaseInstance* instance = new (state) ChaseInstance();
+    instance->magic = CHASE_INSTANCE_MAGIC;
+    instance->snapshotSize = sizeof(GameSnapshot);
+    instance->config = settings;
+    chaseNewGame(*instance, settings.seed);
+    return CHASE_OK;
+}
+
+int chase_reset(void* state, uint32_t seed) {
+    ChaseInstance* instance = chaseInstance(state);
+    if (instance == nullptr) return CHASE_ERROR_INVALID_STATE;
+    std::lock_guard<std::mutex> lock(chaseMutex);
+    engineLog = instance->config.verbose;
+    chaseNewGame(*instance, seed);
+    return CHASE_OK;
+}
+
+int chase_step(void* state, int action, int elapsed_ms, chase_step_result* result) {
+    ChaseInstance* instance = chaseInstance(state);
+    if (instance == nullptr) return CHASE_ERROR_INVALID_STATE;
+    if (action < CHASE_ACTION_UP || action > CHASE_ACTION_STAY || elapsed_ms < 0) return CHASE_ERROR_INVALID_ARGUMENT;
+    std::lock_guard<std::mutex> lock(chaseMutex);
+    engineLog = instance->config.verbose;
+    chase_step_result scratch;
+    chaseStepLocked(*instance, action, elapsed_ms, result != nullptr ? *result : scratch);
+    return CHASE_OK;
+}
+
+int chase_step_batch(void* const* states, int count, const int* actions, int elapsed_ms, chase_step_result* results) {
+    if (count < 0 || (count > 0 && (states == nullptr || actions == nullptr)) || elapsed_ms < 0) return CHASE_ERROR_INVALID_ARGUMENT;
+    for (int i = 0; i < count; ++i) {
+        if (chaseInstance(states[i]) == nullptr) return CHASE_ERROR_INVALID_STATE;
+        if (actions[i] < CHASE_ACTION_UP || actions[i] > CHASE_ACTION_STAY) return CHASE_ERROR_INVALID_ARGUMENT;
+    }
+    std::lock_guard<std::mutex> lock(chaseMutex);
+    // Counting sort by level: the loaded layout only changes between groups.
+    static std::vector<int> order;
+    order.resize(count);
+    int start[MAX_LEVELS + 2] = {};
+    for (int i = 0; i < count; ++i) start[chaseInstance(states[i])->game.level]++;
+    for (int level = 0, sum = 0; level <= MAX_LEVELS + 1; ++level) { int n = start[level]; start[level] = sum; sum += n; }
+    for (int i = 0; i < count; ++i) order[start[chaseInstance(states[i])->game.level]++] = i;
+    for (int i : order) {
+        ChaseInstance* instance = chaseInstance(states[i]);
+        engineLog = instance->config.verbose;
+        chase_step_result scratch;
+        chaseStepLocked(*instance, actions[i], elapsed_ms, results != nullptr ? results[i] : scratch);
+    }
+    return CHASE_OK;
+}
+
+int chase_clone(void* dst, const void* src) {
+    const ChaseInstance* source = chaseInstance(const_cast<void*>(src));
+    if (source == nullptr) return CHASE_ERROR_INVALID_STATE;
+    if (dst == nullptr) return CHASE_ERROR_INVALID_ARGUMENT;
+    if (dst != src) std::memcpy(dst, source, sizeof(ChaseInstance));
+    static_cast<ChaseInstance*>(dst)->encoder.buffer = nullptr; // The clone has not written any buffer yet.
+    return CHASE_OK;
+}
+
+void chase_destroy(void* state) {
+    ChaseInstance* instance = chaseInstance(state);
+    if (instance != nullptr) instance->magic = 0;
+}
+
+int chase_get_info(const void* state, chase_info* info) {
+    const ChaseInstance* instance = chaseInstance(const_cast<void*>(state));
+    if (instance == nullptr) return CHASE_ERROR_INVALID_STATE;
+    if (info == nullptr) return CHASE_ERROR_INVALID_ARGUMENT;
+    const GameSnapshot& game = instance->game;
+    info->level = game.level;
+    info->score = game.score;
+    info->total_score = game.totalScore;
+    info->player_x = game.playerX;
+    info->player_y = game.playerY;
+    info->cat_x = game.catX;
+    info->cat_y = game.catY;
+    info->cheese_left = game.cheese.size();
+    info->cat_delay_ms = game.catDelay;
+    info->cat_slowed = game.catSlowed;
+    info->status = (game.screen == GAME_OVER) ? CHASE_STATUS_CAUGHT : (game.screen == GAME_WON_FINAL) ? CHASE_STATUS_WON : CHASE_STATUS_PLAYING;
+    info->hash = game.hash;
+    return CHASE_OK;
+}
+
+int chase_observe(void* state, uint8_t* out) {
+    ChaseInstance* instance = chaseInstance(state);
+    if (instance == nullptr) return CHASE_ERROR_INVALID_STATE;
+    if (out == nullptr) return CHASE_ERROR_INVALID_ARGUMENT;
+    encodeObservation(instance->game, out, instance->encoder); // Reads only the instance and the once-built wall planes, so no lock is needed.
+    return CHASE_OK;
+}
+
+} // extern "C"
+
+
+// -----------------------------------------------------------------------------
+// NETWORK PLAY (Linux)
+// -----------------------------------------------------------------------------
+
+// --- Wire Protocol ---
+// Clients send fixed-size ClientMessages. The server sends framed messages: a type byte,
+// a payload length byte, then the payload. Both ends are builds of this file on one
+// machine (a Unix-domain socket or loopback TCP), so structs go over the wire as they are.
+const int SERVER_TICK_MS = 20;
+const int SERVER_OUTBOX_BYTES = 256; // Per-session send buffer for when a client's socket is full.
+
+enum ClientMessageType : uint8_t { CLIENT_START = 1, CLIENT_INPUT = 2, CLIENT_ACK = 3, CLIENT_WATCH = 4 };
+struct ClientMessage {
+    uint8_t type;
+    uint8_t arg;       // Level for CLIENT_START, CHASE_ACTION_* for CLIENT_INPUT.
+    uint16_t reserved;
+    uint32_t value;    // Seed for CLIENT_START, sequence number for CLIENT_INPUT, state number for
+                       // CLIENT_ACK, session id for CLIENT_WATCH.
+};
+
+// SERVER_SESSION carries a player's session id (a uint32_t), for spectators to watch.
+enum ServerMessageType : uint8_t { SERVER_STATE = 1, SERVER_DELTA = 2, SERVER_SESSION = 3 };
+struct ServerState {
+    uint32_t tick;
+    uint32_t inputSequence; // Last input applied, so clients can measure their latency.
+    uint16_t score, totalScore;
+    uint8_t status, level, playerX, playerY, catX, catY, catSlowed;
+    uint8_t cheeseCount, powerupCount, ambusherCount;
+    uint8_t cheese[NUM_CHEESE_TO_PLACE][2];
+    uint8_t powerups[NUM_POWERUPS_PER_LEVEL][2];
+    uint8_t ambushers[MAX_AMBUSHERS][2];
+};
+
+#ifdef __linux__
+struct ServerAddress {
+    bool tcp = false;
+    int port = 0;
+    std::string path;
+};
+
+/**
+ * @brief Parses "tcp:<port>" (loopback only) or "unix:<path>"; a bare path means a Unix socket.
+ */
+bool parseServerAddress(const std::string& text, ServerAddress& address) {
+    if (text.rfind("tcp:", 0) == 0) {
+        address.tcp = true;
+        address.port = atoi(text.c_str() + 4);
+        return address.port > 0 && address.port < 65536;
+    }
+    address.tcp = false;
+    address.path = text.rfind("unix:", 0) == 0 ? text.substr(5) : text;
+    return !address.path.empty() && address.path.size() < sizeof(sockaddr_un::sun_path);
+}
+
+/**
+ * @brief Removes a socket file left at a unix address. Anything else at the path is kept,
+ * so a mistyped --serve or --versus path cannot delete a regular file; bind() then fails.
+ */
+void unlinkStaleSocket(const std::string& path) {
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) unlink(path.c_str());
+}
+
+int openServerSocket(const ServerAddress& address, bool listening) {
+    int fd = socket(address.tcp ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int result;
+    if (address.tcp) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(address.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        result = listening ? bind(fd, (sockaddr*)&addr, sizeof(addr)) : connect(fd, (sockaddr*)&addr, sizeof(addr));
+    } else {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, address.path.c_str(), sizeof(addr.sun_path) - 1);
+        if (listening) unlinkStaleSocket(address.path);
+        result = listening ? bind(fd, (sockaddr*)&addr, sizeof(addr)) : connect(fd, (sockaddr*)&addr, sizeof(addr));
+    }
+    if (result == 0 && listening) result = listen(fd, 4096);
+    if (result != 0) { close(fd); return -1; }
+    return fd;
+}
+
+void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ * @brief Lets a process hold as many sockets as the hard limit allows.
+ */
+void raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+#endif
+
+int64_t monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void fillServerState(const GameSnapshot& game, uint32_t tick, uint32_t inputSequence, ServerState& state) {
+    state = ServerState();
+    state.tick = tick;
+    state.inputSequence = inputSequence;
+    state.score = game.score;
+    state.totalScore = game.totalScore;
+    state.status = (game.screen == GAME_OVER) ? CHASE_STATUS_CAUGHT : (game.screen == GAME_WON_FINAL) ? CHASE_STATUS_WON : CHASE_STATUS_PLAYING;
+    state.level = game.level;
+    state.playerX = game.playerX;
+    state.playerY = game.playerY;
+    state.catX = game.catX;
+    state.catY = game.catY;
+    state.catSlowed = game.catSlowed;
+    state.cheeseCount = game.cheese.size();
+    for (int i = 0; i < game.cheese.size(); ++i) { state.cheese[i][0] = game.cheese[i].x; state.cheese[i][1] = game.cheese[i].y; }
+    state.powerupCount = game.powerups.size();
+    for (int i = 0; i < game.powerups.size(); ++i) { state.powerups[i][0] = game.powerups[i].x; state.powerups[i][1] = game.powerups[i].y; }
+    state.ambusherCount = game.ambushers.size();
+    for (int i = 0; i < game.ambushers.size(); ++i) { state.ambushers[i][0] = game.ambushers[i].x; state.ambushers[i][1] = game.ambushers[i].y; }
+}
+
+/**
+ * @brief Shows a server's state in the live game, loading the level's layout if needed.
+ */
+void applyServerState(const ServerState& state) {
+    int level = std::max(1, std::min<int>(state.level, MAX_LEVELS));
+    if (loadedMazeLevel != level) initMaze(level);
+    currentLevel = state.level;
+    currentGameState = (state.status == CHASE_STATUS_CAUGHT) ? GAME_OVER : (state.status == CHASE_STATUS_WON) ? GAME_WON_FINAL : PLAYING;
+    score = state.score;
+    totalScore = state.totalScore;
+    playerX = state.playerX;
+    playerY = state.playerY;
+    catX = state.catX;
+    catY = state.catY;
+    isCatSlowed = state.catSlowed;
+    cheeseLocations.clear();
+    for (int i = 0; i < state.cheeseCount && i < NUM_CHEESE_TO_PLACE; ++i) cheeseLocations.push_back({state.cheese[i][0], state.cheese[i][1]});
+    powerupLocations.clear();
+    for (int i = 0; i < state.powerupCount && i < NUM_POWERUPS_PER_LEVEL; ++i) powerupLocations.push_back({state.powerups[i][0], state.powerups[i][1]});
+    ambushers.clear();
+    for (int i = 0; i < state.ambusherCount && i < MAX_AMBUSHERS; ++i) ambushers.push_back({state.ambushers[i][0], state.ambushers[i][1], PERSONALITY_INTERCEPTOR});
+}
+
+// --- Delta Snapshots ---
+// Once a client acknowledges a state (CLIENT_ACK), the server sends later states as
+// SERVER_DELTAs against the newest acknowledged one. States are numbered per connection in
+// the order they are sent: the stream keeps them in order and sendFrame never drops part
+// of one, so a delta names its baseline by how many states back it is. Both ends keep the
+// last SERVER_DELTA_HISTORY states, and an older baseline gets a full state instead.
+// A delta payload is varints: the baseline distance, a DeltaField mask, the tick
+// difference, then the fields in mask order. Moves are zigzag cell-index differences,
+// cheese and power-ups are bitmasks of the baseline entries collected since, and the
+// scores are differences. A new level or item layout resends the item lists whole.
+const int SERVER_DELTA_HISTORY = 8;
+const int SERVER_DELTA_MAX_BYTES = 96; // Every field changed and a full layout, with room to spare.
+
+enum DeltaField : uint32_t {
+    DELTA_PLAYER = 1 << 0,
+    DELTA_CAT = 1 << 1,
+    DELTA_INPUT = 1 << 2,
+    DELTA_SCORE = 1 << 3,
+    DELTA_CHEESE = 1 << 4,
+    DELTA_POWERUPS = 1 << 5,
+    DELTA_AMBUSHERS = 1 << 6,
+    DELTA_FLAGS = 1 << 7,  // Status and cat slowdown.
+    DELTA_LAYOUT = 1 << 8, // Level, item lists and ambushers, sent whole.
+};
+
+uint8_t* putVarint(uint8_t* out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+bool getVarint(const uint8_t*& in, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35 && in < end; shift += 7) {
+        uint8_t byte = *in++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+/**
+ * @brief Sets a bit in `removed` for each baseline item missing from `items`. Fails unless
+ * `items` is the baseline with some entries taken out (FixedList::erase keeps the order).
+ */
+bool removedItems(const uint8_t (*baseline)[2], int baselineCount, const uint8_t (*items)[2], int count, uint32_t& removed) {
+    removed = 0;
+    int next = 0;
+    for (int i = 0; i < baselineCount; ++i) {
+        if (next < count && items[next][0] == baseline[i][0] && items[next][1] == baseline[i][1]) next++;
+        else removed |= 1u << i;
+    }
+    return next == count;
+}
+
+/**
+ * @brief Writes the delta from `base` to `state` (everything after the baseline distance).
+ * @return The number of bytes written, at most SERVER_DELTA_MAX_BYTES - 1.
+ */
+size_t encodeStateDelta(const ServerState& base, const ServerState& state, uint8_t* out) {
+    uint32_t cheeseGone = 0, powerupsGone = 0, mask = 0;
+    bool sameLayout = state.level == base.level && state.ambusherCount == base.ambusherCount
+                      && removedItems(base.cheese, base.cheeseCount, state.cheese, state.cheeseCount, cheeseGone)
+                      && removedItems(base.powerups, base.powerupCount, state.powerups, state.powerupCount, powerupsGone);
+    int playerMove = (state.playerY - base.playerY) * COLS + state.playerX - base.playerX;
+    int catMove = (state.catY - base.catY) * COLS + state.catX - base.catX;
+    if (playerMove != 0) mask |= DELTA_PLAYER;
+    if (catMove != 0) mask |= DELTA_CAT;
+    if (state.inputSequence != base.inputSequence) mask |= DELTA_INPUT;
+    if (state.score != base.score || state.totalScore != base.totalScore) mask |= DELTA_SCORE;
+    if (state.status != base.status || state.catSlowed != base.catSlowed) mask |= DELTA_FLAGS;
+    if (!sameLayout) mask |= DELTA_LAYOUT;
+    if (sameLayout && cheeseGone != 0) mask |= DELTA_CHEESE;
+    if (sameLayout && powerupsGone != 0) mask |= DELTA_POWERUPS;
+    if (sameLayout && memcmp(state.ambushers, base.ambushers, state.ambusherCount * 2) != 0) mask |= DELTA_AMBUSHERS;
+
+    uint8_t* p = putVarint(out, mask);
+    p = putVarint(p, zigzag((int32_t)(state.tick - base.tick)));
+    if (mask & DELTA_PLAYER) p = putVarint(p, zigzag(playerMove));
+    if (mask & DELTA_CAT) p = putVarint(p, zigzag(catMove));
+    if (mask & DELTA_INPUT) p = putVarint(p, zigzag((int32_t)(state.inputSequence - base.inputSequence)));
+    if (mask & DELTA_SCORE) {
+        p = putVarint(p, zigzag(state.score - base.score));
+        p = putVarint(p, zigzag(state.totalScore - base.totalScore));
+    }
+    if (mask & DELTA_FLAGS) *p++ = state.status | (state.catSlowed << 2);
+    if (mask & DELTA_LAYOUT) {
+        *p++ = state.level;
+        *p++ = state.cheeseCount;
+        for (int i = 0; i < state.cheeseCount; ++i) p = putVarint(p, state.cheese[i][1] * COLS + state.cheese[i][0]);
+        *p++ = state.powerupCount;
+        for (int i = 0; i < state.powerupCount; ++i) p = putVarint(p, state.powerups[i][1] * COLS + state.powerups[i][0]);
+        *p++ = state.ambusherCount;
+        for (int i = 0; i < state.ambusherCount; ++i) p = putVarint(p, state.ambushers[i][1] * COLS + state.ambushers[i][0]);
+    }
+    if (mask & DELTA_CHEESE) p = putVarint(p, cheeseGone);
+    if (mask & DELTA_POWERUPS) p = putVarint(p, powerupsGone);
+    if (mask & DELTA_AMBUSHERS) {
+        for (int i = 0; i < state.ambusherCount; ++i) {
+            p = putVarint(p, zigzag((state.ambushers[i][1] - base.ambushers[i][1]) * COLS + state.ambushers[i][0] - base.ambushers[i][0]));
+        }
+    }
+    return p - out;
+}
+
+/**
+ * @brief Rebuilds a state from its baseline and a delta written by encodeStateDelta.
+ * Malformed input (bad lengths, counts or cells off the grid) is rejected.
+ */
+bool decodeStateDelta(const ServerState& base, const uint8_t* in, size_t size, ServerState& state) {
+    const uint8_t* end = in + size;
+    uint32_t mask, value;
+    state = base;
+    auto setCell = [&](uint8_t* cell, int index) {
+        if (index < 0 || index >= ROWS * COLS) return false;
+        cell[0] = index % COLS;
+        cell[1] = index / COLS;
+        return true;
+    };
+    auto readCell = [&](uint8_t* cell) { return getVarint(in, end, value) && setCell(cell, value); };
+    auto readMove = [&](uint8_t* cell) { return getVarint(in, end, value) && setCell(cell, cell[1] * COLS + cell[0] + unzigzag(value)); };
+    auto readList = [&](uint8_t (*items)[2], uint8_t& count, int capacity) {
+        if (in == end || *in > capacity) return false;
+        count = *in++;
+        for (int i = 0; i < capacity; ++i) {
+            items[i][0] = items[i][1] = 0;
+            if (i < count && !readCell(items[i])) return false;
+        }
+        return true;
+    };
+    auto removeItems = [&](uint8_t (*items)[2], uint8_t& count) {
+        if (!getVarint(in, end, value) || (value >> count) != 0) return false;
+        int kept = 0;
+        for (int i = 0; i < count; ++i) {
+            if (value & (1u << i)) continue;
+            items[kept][0] = items[i][0];
+            items[kept][1] = items[i][1];
+            kept++;
+        }
+        for (int i = kept; i < count; ++i) items[i][0] = items[i][1] = 0;
+        count = kept;
+        return true;
+    };
+
+    if (!getVarint(in, end, mask) || mask >= DELTA_LAYOUT << 1) return false;
+    if (!getVarint(in, end, value)) return false;
+    state.tick = base.tick + unzigzag(value);
+    if ((mask & DELTA_PLAYER) && !readMove(&state.playerX)) return false;
+    if ((mask & DELTA_CAT) && !readMove(&state.catX)) return false;
+    if (mask & DELTA_INPUT) {
+        if (!getVarint(in, end, value)) return false;
+        state.inputSequence = base.inputSequence + unzigzag(value);
+    }
+    if (mask & DELTA_SCORE) {
+        if (!getVarint(in, end, value)) return false;
+        state.score = base.score + unzigzag(value);
+        if (!getVarint(in, end, value)) return false;
+        state.totalScore = base.totalScore + unzigzag(value);
+    }
+    if (mask & DELTA_FLAGS) {
+        if (in == end || (*in & 3) > CHASE_STATUS_WON || *in > 7) return false;
+        state.status = *in & 3;
+        state.catSlowed = *in++ >> 2;
+    }
+    if (mask & DELTA_LAYOUT) {
+        if (in == end) return false;
+        state.level = *in++; // One past MAX_LEVELS once the game is won.
+        if (!readList(state.cheese, state.cheeseCount, NUM_CHEESE_TO_PLACE)) return false;
+        if (!readList(state.powerups, state.powerupCount, NUM_POWERUPS_PER_LEVEL)) return false;
+        if (!readList(state.ambushers, state.ambusherCount, MAX_AMBUSHERS)) return false;
+    }
+    if ((mask & DELTA_CHEESE) && !removeItems(state.cheese, state.cheeseCount)) return false;
+    if ((mask & DELTA_POWERUPS) && !removeItems(state.powerups, state.powerupCount)) return false;
+    if (mask & DELTA_AMBUSHERS) {
+        for (int i = 0; i < state.ambusherCount; ++i) {
+            if (!readMove(state.ambushers[i])) return false;
+        }
+    }
+    return in == end;
+}
+
+// A client's side of the numbering: the states it has decoded, for later deltas to build on.
+struct StateReceiver {
+    ServerState history[SERVER_DELTA_HISTORY];
+    uint32_t numbers[SERVER_DELTA_HISTORY] = {}; // Which state each history slot holds; 0 if none.
+    uint32_t received = 0;                       // States received on the connection so far.
+    uint32_t unacknowledged = 0;                 // Newest state decoded but not yet acknowledged.
+};
+
+/**
+ * @brief Takes one SERVER_STATE or SERVER_DELTA frame.
+ * @return True if it yielded a state; a delta whose baseline is unknown yields none.
+ */
+bool receiveServerFrame(StateReceiver& receiver, uint8_t type, const uint8_t* payload, uint8_t length, ServerState& state) {
+    if (type != SERVER_STATE && type != SERVER_DELTA) return false;
+    uint32_t number = ++receiver.received;
+    if (type == SERVER_STATE) {
+        if (length != sizeof(ServerState)) return false;
+        memcpy(&state, payload, sizeof(state));
+    } else {
+        const uint8_t* p = payload;
+        uint32_t distance;
+        if (!getVarint(p, payload + length, distance) || distance == 0 || distance >= SERVER_DELTA_HISTORY) return false;
+        int slot = (number - distance) % SERVER_DELTA_HISTORY;
+        if (receiver.numbers[slot] != number - distance) return false;
+        if (!decodeStateDelta(receiver.history[slot], p, payload + length - p, state)) return false;
+    }
+    receiver.history[number % SERVER_DELTA_HISTORY] = state;
+    receiver.numbers[number % SERVER_DELTA_HISTORY] = number;
+    receiver.unacknowledged = number;
+    return true;
+}
+
+/**
+ * @brief Encodes the state changes of a recorded bot session against the state before,
+ * as a client acknowledging promptly would receive them, and checks they decode exactly.
+ */
+void benchStateDeltas(int events, std::mt19937& rng) {
+    const char* path = "bench.replay";
+    std::vector<GameSnapshot> trajectory;
+    engineLog = false;
+    bool recorded = recordBotSession(path, events, rng, &trajectory);
+    engineLog = true;
+    std::remove(path);
+    if (!recorded) return;
+
+    int count = trajectory.size();
+    std::vector<ServerState> states(count);
+    uint32_t inputs = 0;
+    for (int i = 0; i < count; ++i) {
+        const GameSnapshot& game = trajectory[i];
+        if (i > 0 && (game.playerX != trajectory[i - 1].playerX || game.playerY != trajectory[i - 1].playerY)) inputs++;
+        fillServerState(game, i, inputs, states[i]);
+    }
+    std::vector<uint8_t> deltas((size_t)count * SERVER_DELTA_MAX_BYTES);
+    std::vector<uint8_t> sizes(count);
+    const int rounds = 20;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 1; i < count; ++i) sizes[i] = encodeStateDelta(states[i - 1], states[i], &deltas[(size_t)i * SERVER_DELTA_MAX_BYTES]);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<ServerState> decoded(count);
+    for (int round = 0; round < rounds; ++round) {
+        for (int i = 1; i < count; ++i) decodeStateDelta(states[i - 1], &deltas[(size_t)i * SERVER_DELTA_MAX_BYTES], sizes[i], decoded[i]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    long long bytes = 0;
+    int largest = 0, small = 0, mismatches = 0;
+    for (int i = 1; i < count; ++i) {
+        int payload = 1 + sizes[i]; // With the baseline distance.
+        bytes += payload;
+        largest = std::max(largest, payload);
+        if (payload < 16) small++;
+        if (memcmp(&decoded[i], &states[i], sizeof(ServerState)) != 0) mismatches++;
+    }
+    double perSecond = (double)rounds * (count - 1) / 1e6;
+    std::cout << "State deltas: " << count - 1 << " updates, average " << (double)bytes / (count - 1) << " bytes (full state " << sizeof(ServerState)
+              << "), " << 100.0 * small / (count - 1) << "% under 16, largest " << largest << "; encode "
+              << perSecond / std::chrono::duration<double>(t1 - t0).count() << " M/s, decode " << perSecond / std::chrono::duration<double>(t2 - t1).count()
+              << " M/s, " << mismatches << " mismatches\n";
+}
+
+// --- Game Server ---
+// --serve <address> [workers] hosts any number of sessions. Workers are processes sharing
+// the listening socket, one per core: the engine runs on globals, so each process gets its
+// own engine and sessions never need a lock.
+// A worker runs one epoll loop: inputs are applied as soon as they arrive and answered
+// with the new state, and a timer advances every session's game clock each
+// SERVER_TICK_MS, sending a state only to sessions where something changed.
+//
+// A connection that sends CLIENT_WATCH becomes a spectator of another session, handed
+// to the worker that runs it if need be. Each tick, a watched session's update is
+// encoded once into a reference-counted BroadcastBuffer. Every spectator's queue points
+// at that same buffer, and a single writev sends a spectator everything it has queued.
+// Updates are deltas against the previous broadcast, so they are the same bytes for every
+// spectator. A spectator that falls SPECTATOR_QUEUE updates behind loses its queue and
+// gets a full state to start again from.
+#ifdef __linux__
+const int SPECTATOR_QUEUE = 32;
+
+struct BroadcastBuffer {
+    int refs = 0;
+    uint16_t size = 0;
+    uint8_t data[2 + 255]; // One frame.
+};
+
+struct Spectator {
+    int fd = -1;
+    int session = -1;      // Slot of the watched session.
+    int index = 0;         // Position in that session's spectator list.
+    bool resync = true;    // Needs a full state before any more deltas.
+    bool writable = true;  // False while waiting for EPOLLOUT.
+    uint16_t sentBytes = 0; // Already written from the oldest queued buffer.
+    uint8_t head = 0, count = 0;
+    BroadcastBuffer* queue[SPECTATOR_QUEUE];
+};
+
+struct ServerSession {
+    alignas(ChaseInstance) unsigned char instance[sizeof(ChaseInstance)];
+    int fd = -1;
+    bool started = false;
+    uint8_t inboxBytes = 0;
+    uint16_t outboxBytes = 0;
+    uint32_t tick = 0;
+    uint32_t inputSequence = 0;
+    uint64_t sentHash = 0;
+    uint32_t sentStates = 0; // States queued on this connection, which numbers them.
+    uint32_t ackedState = 0; // Newest state the client acknowledged, 0 for none.
+    ServerState baseline;    // That state, the base of the deltas sent now.
+    ServerState sent[SERVER_DELTA_HISTORY]; // The latest states queued, by number.
+    uint8_t inbox[sizeof(ClientMessage)];
+    uint8_t outbox[SERVER_OUTBOX_BYTES];
+    std::vector<int> spectators; // Spectator slots watching this session.
+    ServerState broadcast;       // The state they were last sent.
+};
+
+struct ServerWorker {
+    int index = 0; // Worker number, the top bits of the session ids it hands out.
+    int epoll = -1;
+    int listener = -1;
+    int timer = -1;
+    chase_config config;
+    std::vector<ServerSession> sessions;
+    std::vector<int> freeSlots;
+    std::vector<Spectator> spectators;
+    std::vector<int> freeSpectators;
+    std::vector<BroadcastBuffer*> freeBuffers;
+    std::vector<int> handoffs; // Per worker, a datagram socket that passes it connections.
+    int handoffInbox = -1;     // This worker's end of its own.
+    std::vector<void*> stepStates; // Scratch for the batched clock step, reused every tick.
+    std::vector<int> stepActions;
+    std::vector<int> stepSlots;
+    std::vector<chase_step_result> stepResults;
+    int64_t lastTickMs = 0;
+    int liveSessions = 0;
+    int liveSpectators = 0;
+    // Tick cost since the last report, logged every SERVER_REPORT_TICKS ticks while busy.
+    int reportTicks = 0;
+    double tickUsSum = 0, tickUsMax = 0;
+};
+const int SERVER_REPORT_TICKS = 500;
+
+const uint64_t SERVER_LISTENER_TAG = UINT64_MAX;
+const uint64_t SERVER_TIMER_TAG = UINT64_MAX - 1;
+const uint64_t SERVER_HANDOFF_TAG = UINT64_MAX - 2;
+const uint64_t SERVER_SPECTATOR_TAG = 1ull << 32; // Or'ed with a spectator slot.
+const int SERVER_SLOT_BITS = 20;                   // Session ids are (worker + 1) << SERVER_SLOT_BITS | slot.
+
+ChaseInstance& sessionInstance(ServerSession& session) {
+    return *reinterpret_cast<ChaseInstance*>(session.instance);
+}
+
+uint32_t sessionId(const ServerWorker& worker, int slot) {
+    return (uint32_t)(worker.index + 1) << SERVER_SLOT_BITS | slot;
+}
+
+BroadcastBuffer* newBroadcast(ServerWorker& worker, uint8_t type, const void* payload, uint8_t length) {
+    BroadcastBuffer* buffer;
+    if (!worker.freeBuffers.empty()) {
+        buffer = worker.freeBuffers.back();
+        worker.freeBuffers.pop_back();
+    } else {
+        buffer = new BroadcastBuffer();
+    }
+    buffer->refs = 1; // The caller's; spectators add their own.
+    buffer->size = 2 + length;
+    buffer->data[0] = type;
+    buffer->data[1] = length;
+    memcpy(buffer->data + 2, payload, length);
+    return buffer;
+}
+
+void releaseBroadcast(ServerWorker& worker, BroadcastBuffer* buffer) {
+    if (--buffer->refs == 0) worker.freeBuffers.push_back(buffer);
+}
+
+void watchForWrites(ServerWorker& worker, int fd, uint64_t tag, bool writes) {
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLRDHUP | (writes ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.u64 = tag;
+    epoll_ctl(worker.epoll, EPOLL_CTL_MOD, fd, &ev);
+}
+
+/**
+ * @brief Writes as much of a spectator's queue as the socket takes, in one writev.
+ * Errors are left for epoll to report as a hang-up.
+ */
+void flushSpectator(ServerWorker& worker, int slot) {
+    Spectator& spectator = worker.spectators[slot];
+    iovec parts[SPECTATOR_QUEUE];
+    for (int i = 0; i < spectator.count; ++i) {
+        BroadcastBuffer* buffer = spectator.queue[(spectator.head + i) % SPECTATOR_QUEUE];
+        int skip = (i == 0) ? spectator.sentBytes : 0;
+        parts[i].iov_base = buffer->data + skip;
+        parts[i].iov_len = buffer->size - skip;
+    }
+    ssize_t written = spectator.count > 0 ? writev(spectator.fd, parts, spectator.count) : 0;
+    while (written > 0) {
+        BroadcastBuffer* buffer = spectator.queue[spectator.head];
+        ssize_t left = buffer->size - spectator.sentBytes;
+        if (written < left) {
+            spectator.sentBytes += written;
+            break;
+        }
+        written -= left;
+        releaseBroadcast(worker, buffer);
+        spectator.head = (spectator.head + 1) % SPECTATOR_QUEUE;
+        spectator.count--;
+        spectator.sentBytes = 0;
+    }
+    bool blocked = spectator.count > 0;
+    if (blocked == spectator.writable) {
+        spectator.writable = !blocked;
+        watchForWrites(worker, spectator.fd, SERVER_SPECTATOR_TAG | slot, blocked);
+    }
+}
+
+void queueBroadcast(ServerWorker& worker, Spectator& spectator, BroadcastBuffer* buffer) {
+    if (spectator.count == SPECTATOR_QUEUE) {
+        // Too far behind: keep only a frame that is partly written, and start again from a full state.
+        int keep = spectator.sentBytes > 0 ? 1 : 0;
+        for (int i = keep; i < spectator.count; ++i) releaseBroadcast(worker, spectator.queue[(spectator.head + i) % SPECTATOR_QUEUE]);
+        spectator.count = keep;
+        spectator.resync = true;
+        return;
+    }
+    buffer->refs++;
+    spectator.queue[(spectator.head + spectator.count++) % SPECTATOR_QUEUE] = buffer;
+}
+
+void closeSpectator(ServerWorker& worker, int slot) {
+    Spectator& spectator = worker.spectators[slot];
+    close(spectator.fd);
+    for (int i = 0; i < spectator.count; ++i) releaseBroadcast(worker, spectator.queue[(spectator.head + i) % SPECTATOR_QUEUE]);
+    std::vector<int>& audience = worker.sessions[spectator.session].spectators;
+    int moved = audience.back();
+    audience[spectator.index] = moved;
+    worker.spectators[moved].index = spectator.index;
+    audience.pop_back();
+    spectator = Spectator();
+    worker.freeSpectators.push_back(slot);
+    worker.liveSpectators--;
+}
+
+/**
+ * @brief Frees a session slot; the connection itself is the caller's to close or pass on.
+ */
+void releaseSession(ServerWorker& worker, int slot) {
+    ServerSession& session = worker.sessions[slot];
+    while (!session.spectators.empty()) closeSpectator(worker, session.spectators.back());
+    session.fd = -1;
+    session.started = false;
+    worker.freeSlots.push_back(slot);
+    worker.liveSessions--;
+}
+
+void closeSession(ServerWorker& worker, int slot) {
+    close(worker.sessions[slot].fd); // Also removes it from the epoll set.
+    releaseSession(worker, slot);
+}
+
+/**
+ * @brief Makes a connection a spectator of a session in this worker; it is sent a full
+ * state on the next tick.
+ */
+void addSpectator(ServerWorker& worker, int fd, int session) {
+    int slot;
+    if (!worker.freeSpectators.empty()) {
+        slot = worker.freeSpectators.back();
+        worker.freeSpectators.pop_back();
+    } else {
+        slot = worker.spectators.size();
+        worker.spectators.emplace_back();
+    }
+    Spectator& spectator = worker.spectators[slot];
+    spectator.fd = fd;
+    spectator.session = session;
+    spectator.index = worker.sessions[session].spectators.size();
+    worker.sessions[session].spectators.push_back(slot);
+    worker.liveSpectators++;
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.u64 = SERVER_SPECTATOR_TAG | slot;
+    if (epoll_ctl(worker.epoll, EPOLL_CTL_MOD, fd, &ev) != 0) epoll_ctl(worker.epoll, EPOLL_CTL_ADD, fd, &ev);
+}
+
+bool watchableSession(const ServerWorker& worker, uint32_t id) {
+    int slot = id & ((1u << SERVER_SLOT_BITS) - 1);
+    return (int)(id >> SERVER_SLOT_BITS) == worker.index + 1 && slot < (int)worker.sessions.size()
+           && worker.sessions[slot].fd >= 0 && worker.sessions[slot].started;
+}
+
+/**
+ * @brief Turns a player connection into a spectator of session `id`. Sessions on other
+ * workers are reached by passing the socket to that worker.
+ */
+void watchSession(ServerWorker& worker, int slot, uint32_t id) {
+    int fd = worker.sessions[slot].fd;
+    int owner = (int)(id >> SERVER_SLOT_BITS) - 1;
+    if (owner == worker.index) {
+        if (!watchableSession(worker, id) || (int)(id & ((1u << SERVER_SLOT_BITS) - 1)) == slot) { closeSession(worker, slot); return; }
+        releaseSession(worker, slot);
+        addSpectator(worker, fd, id & ((1u << SERVER_SLOT_BITS) - 1));
+        return;
+    }
+    if (owner >= 0 && owner < (int)worker.handoffs.size()) {
+        char control[CMSG_SPACE(sizeof(int))] = {};
+        iovec payload = {&id, sizeof(id)};
+        msghdr message = {};
+        message.msg_iov = &payload;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* rights = CMSG_FIRSTHDR(&message);
+        rights->cmsg_level = SOL_SOCKET;
+        rights->cmsg_type = SCM_RIGHTS;
+        rights->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(rights), &fd, sizeof(int));
+        sendmsg(worker.handoffs[owner], &message, MSG_DONTWAIT);
+        epoll_ctl(worker.epoll, EPOLL_CTL_DEL, fd, nullptr); // The other worker's copy keeps the socket open.
+    }
+    closeSession(worker, slot);
+}
+
+/**
+ * @brief Takes the spectators other workers have passed on.
+ */
+void receiveHandoffs(ServerWorker& worker) {
+    while (true) {
+        uint32_t id;
+        char control[CMSG_SPACE(sizeof(int))];
+        iovec payload = {&id, sizeof(id)};
+        msghdr message = {};
+        message.msg_iov = &payload;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        if (recvmsg(worker.handoffInbox, &message, MSG_DONTWAIT | MSG_CMSG_CLOEXEC) < 0) return;
+        cmsghdr* rights = CMSG_FIRSTHDR(&message);
+        if (rights == nullptr || rights->cmsg_type != SCM_RIGHTS) continue;
+        int fd;
+        memcpy(&fd, CMSG_DATA(rights), sizeof(int));
+        if (!watchableSession(worker, id)) { close(fd); continue; }
+        addSpectator(worker, fd, id & ((1u << SERVER_SLOT_BITS) - 1));
+    }
+}
+
+/**
+ * @brief Sends a watched session's update to its spectators: one delta buffer shared by all
+ * of them, and one full-state buffer shared by those starting over.
+ */
+void broadcastSession(ServerWorker& worker, int slot) {
+    ServerSession& session = worker.sessions[slot];
+    ServerState state;
+    fillServerState(sessionInstance(session).game, session.tick, session.inputSequence, state);
+    bool changed = memcmp(&state, &session.broadcast, sizeof(state)) != 0;
+    BroadcastBuffer* delta = nullptr;
+    BroadcastBuffer* full = nullptr;
+    for (int spectatorSlot : session.spectators) {
+        Spectator& spectator = worker.spectators[spectatorSlot];
+        if (spectator.resync) {
+            if (full == nullptr) full = newBroadcast(worker, SERVER_STATE, &state, sizeof(state));
+            spectator.resync = false;
+            queueBroadcast(worker, spectator, full);
+        } else if (changed) {
+            if (delta == nullptr) {
+                uint8_t payload[SERVER_DELTA_MAX_BYTES];
+                uint8_t* end = putVarint(payload, 1); // Against the previous state, for everyone.
+                end += encodeStateDelta(session.broadcast, state, end);
+                delta = newBroadcast(worker, SERVER_DELTA, payload, end - payload);
+            }
+            queueBroadcast(worker, spectator, delta);
+        } else {
+            continue;
+        }
+        if (spectator.writable) flushSpectator(worker, spectatorSlot);
+    }
+    session.broadcast = state;
+    if (full != nullptr) releaseBroadcast(worker, full);
+    if (delta != nullptr) releaseBroadcast(worker, delta);
+}
+
+void readSpectator(ServerWorker& worker, int slot) {
+    uint8_t buffer[256];
+    ssize_t n;
+    while ((n = recv(worker.spectators[slot].fd, buffer, sizeof(buffer), 0)) > 0) {} // Spectators have nothing to say.
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) closeSpectator(worker, slot);
+}
+
+/**
+ * @brief Queues a framed message; whatever the socket does not take now waits in the
+ * session's outbox. If even the outbox is full the client is not reading, and the message
+ * is dropped whole: the next state supersedes it.
+ * @return False if the message was dropped.
+ */
+bool sendFrame(ServerWorker& worker, int slot, uint8_t type, const void* payload, uint8_t length) {
+    ServerSession& session = worker.sessions[slot];
+    uint8_t frame[2 + 255];
+    frame[0] = type;
+    frame[1] = length;
+    memcpy(frame + 2, payload, length);
+    size_t size = 2 + length, sent = 0;
+    if (session.outboxBytes == 0) {
+        ssize_t n = send(session.fd, frame, size, MSG_NOSIGNAL);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false; // The read side will see the error.
+        sent = std::max<ssize_t>(n, 0);
+    }
+    if (sent == size) return true;
+    if (session.outboxBytes + size - sent > SERVER_OUTBOX_BYTES) return false;
+    bool wasEmpty = (session.outboxBytes == 0);
+    memcpy(session.outbox + session.outboxBytes, frame + sent, size - sent);
+    session.outboxBytes += size - sent;
+    if (wasEmpty) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(worker.epoll, EPOLL_CTL_MOD, session.fd, &ev);
+    }
+    return true;
+}
+
+void flushOutbox(ServerWorker& worker, int slot) {
+    ServerSession& session = worker.sessions[slot];
+    ssize_t n = send(session.fd, session.outbox, session.outboxBytes, MSG_NOSIGNAL);
+    if (n <= 0) return;
+    memmove(session.outbox, session.outbox + n, session.outboxBytes - n);
+    session.outboxBytes -= n;
+    if (session.outboxBytes == 0) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(worker.epoll, EPOLL_CTL_MOD, session.fd, &ev);
+    }
 }
 
 /**
- * @brief Centralized logic to handle player movement and collisions.
- * This is called by both keyboard() and specialKeyboard() to avoid code duplication.
- * @param nextX The proposed new X coordinate for the player.
- * @param nextY The proposed new Y coordinate for the player.
+ * @brief Sends the session's state, as a delta if the client has acknowledged a recent one.
  */
-void processPlayerMove(int nextX, int nextY) {
-    // Handle tunnel wrapping
-    if (nextY == TUNNEL_ROW_INDEX) {
-        if (nextX < 0) nextX = COLS - 1;
-        else if (nextX >= COLS) nextX = 0;
+void sendSessionState(ServerWorker& worker, int slot) {
+    ServerSession& session = worker.sessions[slot];
+    ServerState state;
+    fillServerState(sessionInstance(session).game, session.tick, session.inputSequence, state);
+    session.sentHash = sessionInstance(session).game.hash ^ state.status;
+    uint32_t number = session.sentStates + 1;
+    bool queued;
+    if (session.ackedState != 0 && number - session.ackedState < SERVER_DELTA_HISTORY) {
+        uint8_t delta[SERVER_DELTA_MAX_BYTES];
+        uint8_t* end = putVarint(delta, number - session.ackedState);
+        end += encodeStateDelta(session.baseline, state, end);
+        queued = sendFrame(worker, slot, SERVER_DELTA, delta, end - delta);
+    } else {
+        queued = sendFrame(worker, slot, SERVER_STATE, &state, sizeof(state));
     }
+    if (!queued) return;
+    session.sentStates = number;
+    session.sent[number % SERVER_DELTA_HISTORY] = state;
+}
 
-    // Check if the next move is valid (a path tile)
-    if (nextX >= 0 && nextX < COLS && nextY >= 0 && nextY < ROWS && maze[nextY][nextX] == TILE_PATH) {
-        playerX = nextX;
-        playerY = nextY;
+void handleClientMessage(ServerWorker& worker, int slot, const ClientMessage& message) {
+    ServerSession& session = worker.sessions[slot];
+    if (message.type == CLIENT_START) {
+        chase_config config = worker.config;
+        if (message.arg >= 1 && message.arg <= MAX_LEVELS) config.level = message.arg;
+        config.seed = message.value;
+        session.started = (chase_create(session.instance, &config) == CHASE_OK);
+        session.tick = 0;
+        session.inputSequence = 0;
+        uint32_t id = sessionId(worker, slot);
+        sendFrame(worker, slot, SERVER_SESSION, &id, sizeof(id));
+    } else if (message.type == CLIENT_INPUT && session.started && message.arg <= CHASE_ACTION_STAY) {
+        // Moves are applied at once; the cat's clock only runs on server ticks.
+        chase_step(session.instance, message.arg, 0, nullptr);
+        session.inputSequence = message.value;
+    } else if (message.type == CLIENT_ACK) {
+        uint32_t number = message.value;
+        if (number > session.ackedState && number <= session.sentStates && session.sentStates - number < SERVER_DELTA_HISTORY) {
+            session.ackedState = number;
+            session.baseline = session.sent[number % SERVER_DELTA_HISTORY];
+        }
+        return;
+    } else if (message.type == CLIENT_WATCH) {
+        watchSession(worker, slot, message.value);
+        return;
+    } else {
+        return;
+    }
+    sendSessionState(worker, slot);
+}
 
-        // Check for collision with cheese
-        for (auto it = cheeseLocations.begin(); it != cheeseLocations.end(); ) {
-            if (it->first == playerX && it->second == playerY) {
-                it = cheeseLocations.erase(it);
-                score++;
-                std::cout << "Collected Cheese! Level Score: " << score << " (Current Total: " << totalScore + score << ")" << std::endl;
+void readSession(ServerWorker& worker, int slot) {
+    uint8_t buffer[4096];
+    while (true) {
+        ServerSession& session = worker.sessions[slot];
+        ssize_t n = recv(session.fd, buffer, sizeof(buffer), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) { closeSession(worker, slot); return; }
+        if (n < 0) return;
+        for (ssize_t i = 0; i < n; ++i) {
+            ServerSession& current = worker.sessions[slot];
+            current.inbox[current.inboxBytes++] = buffer[i];
+            if (current.inboxBytes == sizeof(ClientMessage)) {
+                ClientMessage message;
+                memcpy(&message, current.inbox, sizeof(message));
+                current.inboxBytes = 0;
+                int fd = current.fd;
+                handleClientMessage(worker, slot, message);
+                if (worker.sessions[slot].fd != fd) return; // Closed, or now a spectator.
+            }
+        }
+    }
+}
 
-                // Increase cat speed as cheese is collected (non-linear scaling)
-                if (!isCatSlowed && initialCheeseCount > 0) {
-                    float progress = (float)score / initialCheeseCount;
-                    currentCatDelay = MIN_CAT_DELAY_MS + (int)((INITIAL_CAT_DELAY_MS - MIN_CAT_DELAY_MS) * (1.0f - sqrt(progress)));
-                    currentCatDelay = std::max(MIN_CAT_DELAY_MS, currentCatDelay);
-                    normalCatDelayBeforeSlowdown = currentCatDelay;
-                    std::cout << "Cat speed adjusted! New delay: " << currentCatDelay << "ms\n";
-                }
+void acceptSessions(ServerWorker& worker) {
+    while (true) {
+        int fd = accept4(worker.listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or another worker took it.
+        int slot;
+        if (!worker.freeSlots.empty()) {
+            slot = worker.freeSlots.back();
+            worker.freeSlots.pop_back();
+        } else {
+            slot = worker.sessions.size();
+            worker.sessions.emplace_back();
+        }
+        ServerSession& session = worker.sessions[slot];
+        session = ServerSession();
+        session.fd = fd;
+        worker.liveSessions++;
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = slot;
+        epoll_ctl(worker.epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
 
-                if (cheeseLocations.empty()) {
-                    nextLevel();
-                    return; // Exit to prevent further processing this frame
+/**
+ * @brief Advances every running session's clock by the time since the last tick in one
+ * batched step, then sends the new state to the sessions that changed.
+ */
+void serverTick(ServerWorker& worker) {
+    uint64_t expirations;
+    if (read(worker.timer, &expirations, sizeof(expirations)) < 0) return;
+    auto tickStart = std::chrono::steady_clock::now();
+    int64_t now = monotonicMs();
+    int elapsed = (int)std::min<int64_t>(now - worker.lastTickMs, 1000);
+    worker.lastTickMs = now;
+    worker.stepStates.clear();
+    worker.stepActions.clear();
+    worker.stepSlots.clear();
+    for (int slot = 0; slot < (int)worker.sessions.size(); ++slot) {
+        ServerSession& session = worker.sessions[slot];
+        if (session.fd < 0 || !session.started || sessionInstance(session).game.screen != PLAYING) continue;
+        worker.stepStates.push_back(session.instance);
+        worker.stepActions.push_back(CHASE_ACTION_STAY);
+        worker.stepSlots.push_back(slot);
+    }
+    worker.stepResults.resize(worker.stepSlots.size());
+    chase_step_batch(worker.stepStates.data(), worker.stepStates.size(), worker.stepActions.data(), elapsed, worker.stepResults.data());
+    for (int slot : worker.stepSlots) {
+        ServerSession& session = worker.sessions[slot];
+        session.tick++;
+        const GameSnapshot& game = sessionInstance(session).game;
+        if ((game.hash ^ (game.screen == GAME_OVER ? CHASE_STATUS_CAUGHT : game.screen == GAME_WON_FINAL ? CHASE_STATUS_WON : CHASE_STATUS_PLAYING)) != session.sentHash) {
+            sendSessionState(worker, slot);
+        }
+    }
+    for (int slot = 0; slot < (int)worker.sessions.size(); ++slot) {
+        if (!worker.sessions[slot].spectators.empty()) broadcastSession(worker, slot);
+    }
+    double tickUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - tickStart).count();
+    worker.tickUsSum += tickUs;
+    worker.tickUsMax = std::max(worker.tickUsMax, tickUs);
+    if (++worker.reportTicks == SERVER_REPORT_TICKS) {
+        if (worker.liveSessions > 0) {
+            std::cout << "[worker " << getpid() << "] " << worker.liveSessions << " sessions, " << worker.liveSpectators << " spectators, tick " << worker.tickUsSum / SERVER_REPORT_TICKS / 1000.0
+                      << " ms average, " << worker.tickUsMax / 1000.0 << " ms max" << std::endl;
+        }
+        worker.reportTicks = 0;
+        worker.tickUsSum = worker.tickUsMax = 0;
+    }
+}
+
+void runServerWorker(int index, int listener, const std::vector<int>& handoffs, int handoffInbox, const chase_config& config) {
+    ServerWorker worker;
+    worker.index = index;
+    worker.listener = listener;
+    worker.handoffs = handoffs;
+    worker.handoffInbox = handoffInbox;
+    worker.config = config;
+    worker.epoll = epoll_create1(EPOLL_CLOEXEC);
+    worker.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    itimerspec period = {};
+    period.it_interval.tv_nsec = SERVER_TICK_MS * 1000000L;
+    period.it_value = period.it_interval;
+    timerfd_settime(worker.timer, 0, &period, nullptr);
+    worker.lastTickMs = monotonicMs();
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE; // Wake one worker per incoming connection.
+    ev.data.u64 = SERVER_LISTENER_TAG;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, listener, &ev);
+    ev.events = EPOLLIN;
+    ev.data.u64 = SERVER_TIMER_TAG;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, worker.timer, &ev);
+    ev.data.u64 = SERVER_HANDOFF_TAG;
+    epoll_ctl(worker.epoll, EPOLL_CTL_ADD, handoffInbox, &ev);
+
+    epoll_event events[256];
+    while (true) {
+        int count = epoll_wait(worker.epoll, events, 256, -1);
+        if (count < 0 && errno != EINTR) break;
+        for (int i = 0; i < count; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == SERVER_LISTENER_TAG) { acceptSessions(worker); continue; }
+            if (tag == SERVER_TIMER_TAG) { serverTick(worker); continue; }
+            if (tag == SERVER_HANDOFF_TAG) { receiveHandoffs(worker); continue; }
+            if (tag & SERVER_SPECTATOR_TAG) {
+                int spectator = (int)(tag & ~SERVER_SPECTATOR_TAG);
+                if (worker.spectators[spectator].fd < 0) continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) { closeSpectator(worker, spectator); continue; }
+                if (events[i].events & EPOLLOUT) flushSpectator(worker, spectator);
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP)) readSpectator(worker, spectator);
+                continue;
+            }
+            int slot = (int)tag;
+            if (worker.sessions[slot].fd < 0) continue; // Closed earlier in this batch.
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) { closeSession(worker, slot); continue; }
+            if (events[i].events & EPOLLOUT) flushOutbox(worker, slot);
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP)) readSession(worker, slot);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Server entry point: main --serve <address> [workers]. Sessions use the
+ * --pathfinder and --ambushers settings given on the same command line.
+ */
+int runGameServer(const std::string& addressText, int workers) {
+#ifdef __linux__
+    ServerAddress address;
+    if (!parseServerAddress(addressText, address)) { std::cout << "Bad address " << addressText << " (use tcp:<port> or unix:<path>)\n"; return 1; }
+    if (catPathfinder == PATHFINDER_PREDICTIVE) {
+        // Its search runs for a time budget on every cat move and would stall the whole worker's tick.
+        std::cout << "--pathfinder=predictive cannot be served; its search takes up to " << PREDICTIVE_MAX_BUDGET_MS << " ms per cat move.\n";
+        return 1;
+    }
+    raiseFileLimit();
+    int listener = openServerSocket(address, true);
+    if (listener < 0) { std::cout << "Cannot listen on " << addressText << ": " << strerror(errno) << "\n"; return 1; }
+    setNonBlocking(listener);
+    chase_config config;
+    chase_default_config(&config);
+    config.pathfinder = catPathfinder;
+    config.ambusher_count = ambusherPersonalities.size();
+    for (int i = 0; i < config.ambusher_count; ++i) config.ambushers[i] = ambusherPersonalities[i];
+    if (workers <= 0) workers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> handoffs(workers), handoffInboxes(workers);
+    for (int w = 0; w < workers; ++w) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, pair) != 0) { std::cout << "Cannot create worker sockets: " << strerror(errno) << "\n"; return 1; }
+        handoffInboxes[w] = pair[0];
+        handoffs[w] = pair[1];
+    }
+    std::cout << "Serving on " << addressText << " with " << workers << " worker processes, " << sizeof(ServerSession) << " bytes per session.\n";
+    std::cout.flush();
+    signal(SIGPIPE, SIG_IGN);
+    for (int w = 1; w < workers; ++w) {
+        pid_t parent = getpid();
+        if (fork() == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM); // Workers go when the server does.
+            if (getppid() != parent) _exit(0);
+            runServerWorker(w, listener, handoffs, handoffInboxes[w], config);
+            _exit(0);
+        }
+    }
+    runServerWorker(0, listener, handoffs, handoffInboxes[0], config); // The first worker is the server process itself.
+    return 0;
+#else
+    std::cout << "Server mode needs Linux (epoll).\n";
+    return 1;
+#endif
+}
+
+// --- Bot Clients ---
+// --serve-bots <address> [sessions] [seconds] opens many sessions against a server from
+// one epoll loop. Each bot sends a random move every 100 ms, spread evenly over the
+// interval as independent players would be, and times how long the server takes to answer.
+int runServerBots(const std::string& addressText, int sessions, int seconds) {
+#ifdef __linux__
+    ServerAddress address;
+    if (!parseServerAddress(addressText, address)) { std::cout << "Bad address " << addressText << "\n"; return 1; }
+    raiseFileLimit();
+    struct Bot {
+        int fd;
+        uint32_t sequence = 0;
+        int64_t sentAt = 0; // Steady clock, in microseconds, of the unanswered input.
+        int64_t nextInput = 0;
+        bool waiting = false;
+        std::vector<uint8_t> inbox;
+        StateReceiver receiver;
+    };
+    auto nowUs = []() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); };
+    std::vector<Bot> bots;
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    std::mt19937 rng(12345);
+    for (int i = 0; i < sessions; ++i) {
+        int fd = openServerSocket(address, false);
+        if (fd < 0) { std::cout << "Connected " << i << " of " << sessions << " sessions: " << strerror(errno) << "\n"; break; }
+        setNonBlocking(fd);
+        Bot bot;
+        bot.fd = fd;
+        bots.push_back(bot);
+        ClientMessage start = {CLIENT_START, 1, 0, (uint32_t)rng()};
+        send(fd, &start, sizeof(start), MSG_NOSIGNAL);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+    std::vector<double> latencies;
+    long long states = 0, inputs = 0, stateBytes = 0;
+    const int64_t inputIntervalUs = 100000;
+    int64_t end = nowUs() + (int64_t)seconds * 1000000;
+    for (size_t i = 0; i < bots.size(); ++i) bots[i].nextInput = nowUs() + (int64_t)i * inputIntervalUs / bots.size();
+    epoll_event events[256];
+    uint8_t buffer[4096];
+    while (nowUs() < end) {
+        int64_t now = nowUs(), wake = end;
+        for (auto& bot : bots) {
+            if (now >= bot.nextInput && !bot.waiting) {
+                bot.nextInput = std::max(bot.nextInput + inputIntervalUs, now);
+                ClientMessage input = {CLIENT_INPUT, (uint8_t)(rng() % 4), 0, ++bot.sequence};
+                bot.sentAt = nowUs();
+                bot.waiting = true;
+                send(bot.fd, &input, sizeof(input), MSG_NOSIGNAL);
+                inputs++;
+            }
+            if (!bot.waiting) wake = std::min(wake, bot.nextInput); // Waiting bots send again once answered.
+        }
+        int count = epoll_wait(epoll, events, 256, (int)std::max<int64_t>(0, (wake - nowUs()) / 1000));
+        for (int i = 0; i < count; ++i) {
+            Bot& bot = bots[events[i].data.u32];
+            ssize_t n;
+            while ((n = recv(bot.fd, buffer, sizeof(buffer), 0)) > 0) bot.inbox.insert(bot.inbox.end(), buffer, buffer + n);
+            size_t used = 0;
+            while (bot.inbox.size() - used >= 2 && bot.inbox.size() - used >= 2u + bot.inbox[used + 1]) {
+                ServerState state;
+                if (receiveServerFrame(bot.receiver, bot.inbox[used], bot.inbox.data() + used + 2, bot.inbox[used + 1], state)) {
+                    states++;
+                    stateBytes += 2 + bot.inbox[used + 1];
+                    if (bot.waiting && state.inputSequence == bot.sequence) {
+                        latencies.push_back((nowUs() - bot.sentAt) / 1000.0);
+                        bot.waiting = false;
+                    }
+                    if (state.status != CHASE_STATUS_PLAYING) {
+                        ClientMessage start = {CLIENT_START, 1, 0, (uint32_t)rng()};
+                        send(bot.fd, &start, sizeof(start), MSG_NOSIGNAL);
+                    }
                 }
-                break;
-            } else {
-                ++it;
+                used += 2 + bot.inbox[used + 1];
+            }
+            bot.inbox.erase(bot.inbox.begin(), bot.inbox.begin() + used);
+            if (bot.receiver.unacknowledged != 0) {
+                ClientMessage ack = {CLIENT_ACK, 0, 0, bot.receiver.unacknowledged};
+                send(bot.fd, &ack, sizeof(ack), MSG_NOSIGNAL);
+                bot.receiver.unacknowledged = 0;
             }
         }
+    }
+    for (auto& bot : bots) close(bot.fd);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, (size_t)(p * latencies.size()))]; };
+    std::cout << bots.size() << " sessions for " << seconds << " s: " << inputs << " inputs, " << states << " states received, "
+              << (states > 0 ? (double)stateBytes / states : 0.0) << " bytes each on the wire; input latency p50 "
+              << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms, max " << (latencies.empty() ? 0.0 : latencies.back()) << " ms\n";
+    return 0;
+#else
+    std::cout << "Bot clients need Linux (epoll).\n";
+    return 1;
+#endif
+}
 
-        // Check for collision with power-ups
-        for (auto it = powerupLocations.begin(); it != powerupLocations.end(); ) {
-            if(it->x == playerX && it->y == playerY) {
-                if (it->type == TILE_SLOW_POWERUP && !isCatSlowed) {
-                    std::cout << "Powerup Collected: Cat Slowdown!\n";
-                    isCatSlowed = true;
-                    catSlowDurationTimer = CAT_SLOW_DURATION_MS;
-                    normalCatDelayBeforeSlowdown = currentCatDelay;
-                    currentCatDelay = std::max(currentCatDelay, INITIAL_CAT_DELAY_MS + 100);
-                    std::cout << "Cat slowed! Delay: " << currentCatDelay << "ms\n";
-                    it = powerupLocations.erase(it);
-                    break;
+// --- Spectator Load ---
+// --serve-spectators <address> [spectators] [seconds] starts one bot game and has
+// `spectators` connections watch it. It reports how long each update takes to reach every
+// spectator, measured from the first to the last to receive it.
+int runServerSpectators(const std::string& addressText, int count, int seconds) {
+#ifdef __linux__
+    ServerAddress address;
+    if (!parseServerAddress(addressText, address)) { std::cout << "Bad address " << addressText << "\n"; return 1; }
+    raiseFileLimit();
+    auto nowUs = []() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); };
+    std::mt19937 rng(54321);
+    int player = openServerSocket(address, false);
+    if (player < 0) { std::cout << "Cannot connect to " << addressText << ": " << strerror(errno) << "\n"; return 1; }
+    ClientMessage start = {CLIENT_START, 1, 0, (uint32_t)rng()};
+    send(player, &start, sizeof(start), MSG_NOSIGNAL);
+    uint8_t frame[2 + 255];
+    uint32_t session = 0;
+    while (session == 0) {
+        if (recv(player, frame, 2, MSG_WAITALL) != 2 || recv(player, frame + 2, frame[1], MSG_WAITALL) != frame[1]) { std::cout << "The server closed the game.\n"; return 1; }
+        if (frame[0] == SERVER_SESSION && frame[1] == sizeof(session)) memcpy(&session, frame + 2, sizeof(session));
+    }
+    setNonBlocking(player);
+
+    struct Watcher {
+        int fd;
+        std::vector<uint8_t> inbox;
+        StateReceiver receiver;
+        uint32_t games = 0, lastTick = 0; // The tick restarts with each new game.
+    };
+    std::vector<Watcher> watchers;
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < count; ++i) {
+        int fd = openServerSocket(address, false);
+        if (fd < 0) { std::cout << "Connected " << i << " of " << count << " spectators: " << strerror(errno) << "\n"; break; }
+        setNonBlocking(fd);
+        watchers.push_back({fd, {}, {}});
+        ClientMessage watch = {CLIENT_WATCH, 0, 0, session};
+        send(fd, &watch, sizeof(watch), MSG_NOSIGNAL);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = i;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    // First and last arrival of each update, keyed by game and server tick (one broadcast per tick).
+    std::unordered_map<uint64_t, std::pair<int64_t, int64_t>> arrivals;
+    long long states = 0, bytes = 0, failures = 0;
+    int closed = 0;
+    int64_t end = nowUs() + (int64_t)seconds * 1000000, nextMove = nowUs();
+    epoll_event events[256];
+    uint8_t buffer[4096];
+    std::vector<uint8_t> playerInbox;
+    while (nowUs() < end) {
+        if (nowUs() >= nextMove) {
+            nextMove += 100000;
+            ClientMessage input = {CLIENT_INPUT, (uint8_t)(rng() % 4), 0, 0};
+            send(player, &input, sizeof(input), MSG_NOSIGNAL);
+            // The player never acknowledges, so its own states arrive whole; a caught player starts over.
+            ssize_t n;
+            while ((n = recv(player, buffer, sizeof(buffer), 0)) > 0) playerInbox.insert(playerInbox.end(), buffer, buffer + n);
+            size_t used = 0;
+            bool over = false;
+            while (playerInbox.size() - used >= 2 && playerInbox.size() - used >= 2u + playerInbox[used + 1]) {
+                if (playerInbox[used] == SERVER_STATE && playerInbox[used + 1] == sizeof(ServerState)) {
+                    ServerState state;
+                    memcpy(&state, playerInbox.data() + used + 2, sizeof(state));
+                    over = (state.status != CHASE_STATUS_PLAYING);
+                }
+                used += 2 + playerInbox[used + 1];
+            }
+            playerInbox.erase(playerInbox.begin(), playerInbox.begin() + used);
+            if (over) {
+                ClientMessage restart = {CLIENT_START, 1, 0, (uint32_t)rng()};
+                send(player, &restart, sizeof(restart), MSG_NOSIGNAL);
+            }
+        }
+        int ready = epoll_wait(epoll, events, 256, 10);
+        int64_t now = nowUs();
+        for (int i = 0; i < ready; ++i) {
+            Watcher& watcher = watchers[events[i].data.u32];
+            ssize_t n;
+            while ((n = recv(watcher.fd, buffer, sizeof(buffer), 0)) > 0) watcher.inbox.insert(watcher.inbox.end(), buffer, buffer + n);
+            if (n == 0) { closed++; epoll_ctl(epoll, EPOLL_CTL_DEL, watcher.fd, nullptr); }
+            size_t used = 0;
+            while (watcher.inbox.size() - used >= 2 && watcher.inbox.size() - used >= 2u + watcher.inbox[used + 1]) {
+                ServerState state;
+                if (receiveServerFrame(watcher.receiver, watcher.inbox[used], watcher.inbox.data() + used + 2, watcher.inbox[used + 1], state)) {
+                    states++;
+                    bytes += 2 + watcher.inbox[used + 1];
+                    if (state.tick < watcher.lastTick) watcher.games++;
+                    watcher.lastTick = state.tick;
+                    auto found = arrivals.emplace((uint64_t)watcher.games << 32 | state.tick, std::make_pair(now, now));
+                    found.first->second.second = now;
                 } else {
-                    ++it;
+                    failures++;
                 }
-            } else {
-                ++it;
+                used += 2 + watcher.inbox[used + 1];
             }
+            watcher.inbox.erase(watcher.inbox.begin(), watcher.inbox.begin() + used);
         }
-        glutPostRedisplay();
+    }
+    std::vector<double> spreads;
+    for (const auto& entry : arrivals) spreads.push_back((entry.second.second - entry.second.first) / 1000.0);
+    std::sort(spreads.begin(), spreads.end());
+    auto percentile = [&](double p) { return spreads.empty() ? 0.0 : spreads[std::min(spreads.size() - 1, (size_t)(p * spreads.size()))]; };
+    std::cout << watchers.size() << " spectators of session " << session << " for " << seconds << " s: " << arrivals.size() << " updates, " << states
+              << " states received, " << (states > 0 ? (double)bytes / states : 0.0) << " bytes each, " << failures << " undecodable, " << closed
+              << " dropped; fan-out p50 " << percentile(0.5) << " ms, p99 " << percentile(0.99) << " ms, max " << (spreads.empty() ? 0.0 : spreads.back()) << " ms\n";
+    for (auto& watcher : watchers) close(watcher.fd);
+    close(player);
+    return 0;
+#else
+    std::cout << "Spectator clients need Linux (epoll).\n";
+    return 1;
+#endif
+}
+
+// --- Network Client ---
+// --connect=<address> turns the window into a thin client: keys are sent to the server
+// and the display shows the states it sends back. With --watch=<session id> it spectates
+// another player's session instead.
+int networkClientSocket = -1;
+uint32_t networkInputSequence = 0;
+bool networkWatching = false;
+std::vector<uint8_t> networkInbox;
+StateReceiver networkReceiver;
+
+void sendClientMessage(uint8_t type, uint8_t arg, uint32_t value) {
+#ifdef __linux__
+    ClientMessage message = {type, arg, 0, value};
+    send(networkClientSocket, &message, sizeof(message), MSG_NOSIGNAL);
+#endif
+}
+
+#ifndef CHASE_LIBRARY
+void networkClientKeyboard(unsigned char key, int x, int y) {
+    if (key == 27) exit(0);
+    if (networkWatching) return;
+    if (key == 'r' || key == 'R' || key == 13) { sendClientMessage(CLIENT_START, 1, (uint32_t)time(0)); return; }
+    switch (key) {
+        case 'w': case 'W': sendClientMessage(CLIENT_INPUT, CHASE_ACTION_UP, ++networkInputSequence); break;
+        case 's': case 'S': sendClientMessage(CLIENT_INPUT, CHASE_ACTION_DOWN, ++networkInputSequence); break;
+        case 'a': case 'A': sendClientMessage(CLIENT_INPUT, CHASE_ACTION_LEFT, ++networkInputSequence); break;
+        case 'd': case 'D': sendClientMessage(CLIENT_INPUT, CHASE_ACTION_RIGHT, ++networkInputSequence); break;
+    }
+}
+
+void networkClientSpecialKeyboard(int key, int x, int y) {
+    if (networkWatching) return;
+    switch (key) {
+        case GLUT_KEY_UP:    sendClientMessage(CLIENT_INPUT, CHASE_ACTION_UP, ++networkInputSequence); break;
+        case GLUT_KEY_DOWN:  sendClientMessage(CLIENT_INPUT, CHASE_ACTION_DOWN, ++networkInputSequence); break;
+        case GLUT_KEY_LEFT:  sendClientMessage(CLIENT_INPUT, CHASE_ACTION_LEFT, ++networkInputSequence); break;
+        case GLUT_KEY_RIGHT: sendClientMessage(CLIENT_INPUT, CHASE_ACTION_RIGHT, ++networkInputSequence); break;
     }
 }
 
 /**
- * @brief Sets up initial OpenGL states like blending and anti-aliasing.
+ * @brief Idle callback in client mode: applies every state that has arrived.
  */
-void initOpenGL() {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(0.0, WINDOW_WIDTH, WINDOW_HEIGHT, 0.0);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    glEnable(GL_LINE_SMOOTH);
-    glEnable(GL_POLYGON_SMOOTH);
-    glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
-    glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+void networkClientIdle() {
+#ifdef __linux__
+    uint8_t buffer[4096];
+    ssize_t n;
+    bool changed = false;
+    while ((n = recv(networkClientSocket, buffer, sizeof(buffer), 0)) > 0) networkInbox.insert(networkInbox.end(), buffer, buffer + n);
+    if (n == 0) { std::cout << "Server closed the connection.\n"; exit(0); }
+    size_t used = 0;
+    while (networkInbox.size() - used >= 2 && networkInbox.size() - used >= 2u + networkInbox[used + 1]) {
+        ServerState state;
+        if (receiveServerFrame(networkReceiver, networkInbox[used], networkInbox.data() + used + 2, networkInbox[used + 1], state)) {
+            applyServerState(state);
+            changed = true;
+        } else if (networkInbox[used] == SERVER_SESSION && networkInbox[used + 1] == sizeof(uint32_t)) {
+            uint32_t id;
+            memcpy(&id, networkInbox.data() + used + 2, sizeof(id));
+            std::cout << "Session " << id << ": others can watch with --watch=" << id << "\n";
+        }
+        used += 2 + networkInbox[used + 1];
+    }
+    networkInbox.erase(networkInbox.begin(), networkInbox.begin() + used);
+    if (networkReceiver.unacknowledged != 0 && !networkWatching) {
+        sendClientMessage(CLIENT_ACK, 0, networkReceiver.unacknowledged);
+        networkReceiver.unacknowledged = 0;
+    }
+    if (changed) glutPostRedisplay();
+#endif
 }
+#endif // CHASE_LIBRARY
 
 /**
- * @brief Idle callback for time-based updates, such as animations and timers.
+ * @brief Connects to a server for --connect=<address>, to play or, given a session id,
+ * to watch.
  */
-void idle() {
-    int currentTime = glutGet(GLUT_ELAPSED_TIME);
-    int deltaTime = currentTime - lastTickTime;
+bool startNetworkClient(const std::string& addressText, uint32_t watchSession) {
+#ifdef __linux__
+    ServerAddress address;
+    if (!parseServerAddress(addressText, address)) return false;
+    networkClientSocket = openServerSocket(address, false);
+    if (networkClientSocket < 0) return false;
+    setNonBlocking(networkClientSocket);
+    signal(SIGPIPE, SIG_IGN);
+    networkClient = true;
+    networkWatching = (watchSession != 0);
+    if (networkWatching) sendClientMessage(CLIENT_WATCH, 0, watchSession);
+    else sendClientMessage(CLIENT_START, 1, (uint32_t)time(0));
+    return true;
+#else
+    return false;
+#endif
+}
 
-    if (deltaTime > 0) {
-        if (currentGameState == PLAYING || currentGameState == PAUSED) {
-            // Animate power-up sparkle effect
-            for(auto& p : powerupLocations) {
-                p.sparklePhase += deltaTime * 0.005f;
-                if (p.sparklePhase > TWICE_PI) p.sparklePhase -= TWICE_PI;
-            }
-            // Decrement the cat slowdown timer
-            if(isCatSlowed && currentGameState == PLAYING) {
-                catSlowDurationTimer -= deltaTime;
-                if(catSlowDurationTimer <= 0) {
-                    isCatSlowed = false;
-                    // Restore cat speed to its normal value for the current progress
-                    if(initialCheeseCount > 0) {
-                        float progress = (float)score / initialCheeseCount;
-                        currentCatDelay = MIN_CAT_DELAY_MS + (int)((INITIAL_CAT_DELAY_MS - MIN_CAT_DELAY_MS) * (1.0f - sqrt(progress)));
-                        currentCatDelay = std::max(MIN_CAT_DELAY_MS, currentCatDelay);
-                    } else {
-                        currentCatDelay = normalCatDelayBeforeSlowdown;
-                    }
-                    std::cout << "Cat slowdown ended! Delay restored to: " << currentCatDelay << "ms\n";
-                }
-            }
+// --- Versus Play ---
+// --versus=host:<address> and --versus=join:<address> connect two windows for a
+// cat-vs-mouse match: the host plays the mouse and the joining side steers the cat.
+// Both run the same fixed VERSUS_TICK_MS ticks from the host's seed. Each side sends its
+// input for every tick and, rather than wait for the other's, predicts that the opponent
+// pressed nothing. When a real input differs from the prediction, the state from before
+// that tick is restored from a ring of snapshots and the ticks since are re-simulated.
+// --latency=<ms> holds outgoing messages back to try this on one machine.
+const int VERSUS_TICK_MS = 20;
+const int VERSUS_MAX_AHEAD = 16;   // Ticks a side may run past the last input it has from the other.
+const int VERSUS_HISTORY = 64;     // Snapshot and input ring; covers VERSUS_MAX_AHEAD either way.
+const int VERSUS_PAUSE_TICKS = 100; // Shown between levels and after a game, then play resumes.
+const int VERSUS_REPORT_TICKS = 500;
+
+enum VersusMessageType : uint8_t { VERSUS_HELLO = 1, VERSUS_INPUT = 2 };
+const uint8_t VERSUS_OPTIMIZED_PLACEMENT = 1; // VERSUS_HELLO option: the host places items with --placement=optimized.
+struct VersusMessage {
+    uint8_t type;
+    uint8_t input;    // CHASE_ACTION_* for VERSUS_INPUT, VERSUS_* options for VERSUS_HELLO.
+    uint16_t reserved;
+    uint32_t value;   // Seed for VERSUS_HELLO, tick for VERSUS_INPUT.
+};
+
+// What a tick reads and writes besides the game snapshot travels with it.
+struct VersusFrame {
+    GameSnapshot game;
+    int catHeading;
+    int pauseTicks; // Ticks spent on a level-cleared or game-over screen.
+};
+
+struct VersusSession {
+    int socket = -1;
+    bool catSide = false; // This side steers the cat; the other moves the mouse.
+    int latencyMs = 0;
+    int pauseTicks = 0;
+    VersusFrame frames[VERSUS_HISTORY];   // The state before each tick, by tick.
+    uint8_t localInputs[VERSUS_HISTORY];
+    uint8_t remoteInputs[VERSUS_HISTORY];
+    uint8_t usedRemote[VERSUS_HISTORY];   // What each simulated tick assumed the opponent did.
+    uint32_t tick = 0;                    // Next tick to simulate.
+    uint32_t endTick = UINT32_MAX;        // Headless runs stop simulating here.
+    uint32_t reportTick = 0;
+    uint32_t remoteTicks = 0;             // Opponent inputs are known for the ticks below this.
+    uint32_t rollbackFrom = UINT32_MAX;   // Earliest tick simulated with a wrong guess.
+    uint8_t pendingInput = CHASE_ACTION_STAY; // Pressed since the last tick.
+    int64_t startMs = 0;
+    std::deque<std::pair<int64_t, VersusMessage>> outgoing; // Held back by --latency.
+    std::vector<uint8_t> inbox;
+    // Rollback statistics.
+    long long rollbacks = 0, resimulatedTicks = 0, stalls = 0;
+    int longestRollback = 0;
+    double rollbackUsSum = 0, rollbackUsMax = 0;
+};
+VersusSession versus;
+
+/**
+ * @brief Advances the game by one tick with both players' inputs. Deterministic: it only
+ * reads the game state, the cat heading and the pause counter, all kept in VersusFrame.
+ */
+void versusTick(VersusSession& s, int mouseAction, int catAction) {
+    if (catAction <= CHASE_ACTION_RIGHT) playerCatHeading = catAction;
+    if (currentGameState != PLAYING) {
+        if (++s.pauseTicks < VERSUS_PAUSE_TICKS) return;
+        s.pauseTicks = 0;
+        playerCatHeading = -1;
+        if (currentGameState == GAME_WON_LEVEL) {
+            startLevel(currentLevel);
+        } else {
+            uint32_t seed = liveGame.randomState;
+            liveGame = GameSnapshot();
+            liveGame.randomState = seed;
+            startLevel(1);
         }
-        lastTickTime = currentTime;
+        return;
     }
-    glutPostRedisplay();
+    if (mouseAction <= CHASE_ACTION_RIGHT) applyPlayerMove((Direction)mouseAction);
+    if (currentGameState == PLAYING) advanceGameClock(VERSUS_TICK_MS);
+}
+
+void versusSaveFrame(VersusSession& s, VersusFrame& frame) {
+    snapshotGame(frame.game);
+    frame.catHeading = playerCatHeading;
+    frame.pauseTicks = s.pauseTicks;
+}
+
+void versusLoadFrame(VersusSession& s, const VersusFrame& frame) {
+    restoreGame(frame.game);
+    playerCatHeading = frame.catHeading;
+    s.pauseTicks = frame.pauseTicks;
 }
 
 /**
- * @brief Reshape callback that maintains the game's aspect ratio.
- * This function adds black bars (letterboxing/pillarboxing) if the window
- * is resized to a non-proportional shape.
- * @param w The new window width.
- * @param h The new window height.
+ * @brief Simulates tick `t` from the current state, saving that state first so the tick
+ * can be rolled back. Uses the opponent's input if it has arrived, otherwise a guess.
  */
-void reshape(int w, int h) {
-    if (h == 0) h = 1;
-    float gameAspect = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
-    float windowAspect = (float)w / (float)h;
+void versusSimulate(VersusSession& s, uint32_t t) {
+    int slot = t % VERSUS_HISTORY;
+    versusSaveFrame(s, s.frames[slot]);
+    s.usedRemote[slot] = (t < s.remoteTicks) ? s.remoteInputs[slot] : CHASE_ACTION_STAY;
+    int local = s.localInputs[slot], remote = s.usedRemote[slot];
+    versusTick(s, s.catSide ? remote : local, s.catSide ? local : remote);
+}
 
-    int newViewportW, newViewportH, newViewportX, newViewportY;
+/**
+ * @brief Restores the state from before the first mispredicted tick and re-simulates
+ * every tick since, now with the inputs that have arrived.
+ */
+void versusRollback(VersusSession& s) {
+    if (s.rollbackFrom >= s.tick) { s.rollbackFrom = UINT32_MAX; return; }
+    auto t0 = std::chrono::steady_clock::now();
+    int ticks = s.tick - s.rollbackFrom;
+    bool logged = engineLog;
+    engineLog = false; // The ticks already logged their pickups once.
+    versusLoadFrame(s, s.frames[s.rollbackFrom % VERSUS_HISTORY]);
+    for (uint32_t t = s.rollbackFrom; t < s.tick; ++t) versusSimulate(s, t);
+    engineLog = logged;
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    s.rollbacks++;
+    s.resimulatedTicks += ticks;
+    s.longestRollback = std::max(s.longestRollback, ticks);
+    s.rollbackUsSum += us;
+    s.rollbackUsMax = std::max(s.rollbackUsMax, us);
+    s.rollbackFrom = UINT32_MAX;
+}
 
-    if (windowAspect > gameAspect) {
-        // Window is wider than the game (pillarbox)
-        newViewportH = h;
-        newViewportW = (int)(h * gameAspect);
-        newViewportX = (w - newViewportW) / 2;
-        newViewportY = 0;
+/**
+ * @brief Records the opponent's input for the next tick, noting a rollback if that tick
+ * was already simulated with a different guess.
+ */
+void versusReceiveInput(VersusSession& s, uint8_t input) {
+    uint32_t t = s.remoteTicks++;
+    int slot = t % VERSUS_HISTORY;
+    s.remoteInputs[slot] = input;
+    if (t < s.tick && s.usedRemote[slot] != input) s.rollbackFrom = std::min(s.rollbackFrom, t);
+}
+
+void versusSend(VersusSession& s, const VersusMessage& message) {
+#ifdef __linux__
+    if (s.socket < 0) return;
+    if (s.latencyMs <= 0 && s.outgoing.empty()) {
+        send(s.socket, &message, sizeof(message), MSG_NOSIGNAL);
+        return;
+    }
+    s.outgoing.push_back({monotonicMs() + s.latencyMs, message});
+#endif
+}
+
+/**
+ * @brief Sends the held-back messages that are due.
+ * @return True once nothing is held back.
+ */
+bool versusFlush(VersusSession& s) {
+#ifdef __linux__
+    int64_t now = monotonicMs();
+    while (!s.outgoing.empty() && s.outgoing.front().first <= now) {
+        send(s.socket, &s.outgoing.front().second, sizeof(VersusMessage), MSG_NOSIGNAL);
+        s.outgoing.pop_front();
+    }
+#endif
+    return s.outgoing.empty();
+}
+
+/**
+ * @brief Runs the local ticks due by the clock, each with the input pressed since the last
+ * one. A side that gets VERSUS_MAX_AHEAD ticks past the opponent's inputs waits for them.
+ * @return True if any tick ran.
+ */
+bool versusAdvance(VersusSession& s, uint32_t targetTick) {
+    bool advanced = false;
+    while (s.tick < targetTick) {
+        if (s.tick >= s.remoteTicks + VERSUS_MAX_AHEAD) { s.stalls++; break; }
+        s.localInputs[s.tick % VERSUS_HISTORY] = s.pendingInput;
+        s.pendingInput = CHASE_ACTION_STAY;
+        versusSend(s, {VERSUS_INPUT, s.localInputs[s.tick % VERSUS_HISTORY], 0, s.tick});
+        versusSimulate(s, s.tick);
+        s.tick++;
+        advanced = true;
+    }
+    return advanced;
+}
+
+/**
+ * @brief Starts the match from the host's seed and options on both sides.
+ */
+void versusStart(VersusSession& s, uint32_t seed, uint8_t options = 0) {
+    catPathfinder = PATHFINDER_PLAYER;
+    ambusherPersonalities.clear();
+    optimizeItemPlacement = (options & VERSUS_OPTIMIZED_PLACEMENT) != 0;
+    // Each side may have its own difficulty.cfg, and its curves were fitted to the computer cat anyway.
+    std::fill(levelSpeedCurves, levelSpeedCurves + MAX_LEVELS + 1, CatSpeedCurve());
+    liveGame = GameSnapshot();
+    liveGame.randomState = seed != 0 ? seed : GameSnapshot().randomState;
+    playerCatHeading = -1;
+    startLevel(1);
+    s.startMs = monotonicMs();
+}
+
+/**
+ * @brief Reads the opponent's messages, rolls back if a guess was wrong, runs the ticks
+ * that are due and sends what the latency delay has released.
+ * @return False when the opponent has gone.
+ */
+bool versusPump(VersusSession& s, bool& changed) {
+#ifdef __linux__
+    uint8_t buffer[4096];
+    ssize_t n;
+    while ((n = recv(s.socket, buffer, sizeof(buffer), 0)) > 0) s.inbox.insert(s.inbox.end(), buffer, buffer + n);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) return false;
+    size_t used = 0;
+    for (; s.inbox.size() - used >= sizeof(VersusMessage); used += sizeof(VersusMessage)) {
+        VersusMessage message;
+        memcpy(&message, s.inbox.data() + used, sizeof(message));
+        if (message.type == VERSUS_HELLO && s.startMs == 0) versusStart(s, message.value, message.input);
+        else if (message.type == VERSUS_INPUT && message.value == s.remoteTicks && message.input <= CHASE_ACTION_STAY) versusReceiveInput(s, message.input);
+    }
+    s.inbox.erase(s.inbox.begin(), s.inbox.begin() + used);
+    if (s.startMs == 0) return true; // Still waiting for the host.
+    if (s.rollbackFrom != UINT32_MAX) {
+        versusRollback(s);
+        changed = true;
+    }
+    changed = versusAdvance(s, std::min<int64_t>((monotonicMs() - s.startMs) / VERSUS_TICK_MS, s.endTick)) || changed;
+    versusFlush(s);
+#endif
+    return true;
+}
+
+void printVersusStats(const VersusSession& s) {
+    std::cout << "[versus] tick " << s.tick << ": " << s.rollbacks << " rollbacks, " << (s.rollbacks ? (double)s.resimulatedTicks / s.rollbacks : 0.0)
+              << " ticks re-simulated on average (longest " << s.longestRollback << "), " << (s.rollbacks ? s.rollbackUsSum / s.rollbacks : 0.0)
+              << " us average, " << s.rollbackUsMax << " us max; " << s.stalls << " frames waited for the opponent" << std::endl;
+}
+
+#ifndef CHASE_LIBRARY
+void versusIdle() {
+    bool changed = false;
+    if (!versusPump(versus, changed)) {
+        printVersusStats(versus);
+        std::cout << "Opponent left.\n";
+        exit(0);
+    }
+    if (versus.tick >= versus.reportTick + VERSUS_REPORT_TICKS) {
+        printVersusStats(versus);
+        versus.reportTick = versus.tick;
+    }
+    if (changed) glutPostRedisplay();
+}
+
+void versusKeyboard(unsigned char key, int x, int y) {
+    switch (key) {
+        case 27: printVersusStats(versus); exit(0);
+        case 'w': case 'W': versus.pendingInput = CHASE_ACTION_UP; break;
+        case 's': case 'S': versus.pendingInput = CHASE_ACTION_DOWN; break;
+        case 'a': case 'A': versus.pendingInput = CHASE_ACTION_LEFT; break;
+        case 'd': case 'D': versus.pendingInput = CHASE_ACTION_RIGHT; break;
+    }
+}
+
+void versusSpecialKeyboard(int key, int x, int y) {
+    switch (key) {
+        case GLUT_KEY_UP:    versus.pendingInput = CHASE_ACTION_UP; break;
+        case GLUT_KEY_DOWN:  versus.pendingInput = CHASE_ACTION_DOWN; break;
+        case GLUT_KEY_LEFT:  versus.pendingInput = CHASE_ACTION_LEFT; break;
+        case GLUT_KEY_RIGHT: versus.pendingInput = CHASE_ACTION_RIGHT; break;
+    }
+}
+#endif // CHASE_LIBRARY
+
+/**
+ * @brief Connects the two sides for --versus=host:<address> or --versus=join:<address>.
+ * The host waits for the other side, then sends the seed.
+ */
+bool startVersus(const std::string& spec, int latencyMs) {
+#ifdef __linux__
+    bool host = spec.rfind("host:", 0) == 0;
+    if (!host && spec.rfind("join:", 0) != 0) return false;
+    ServerAddress address;
+    if (!parseServerAddress(spec.substr(5), address)) return false;
+    signal(SIGPIPE, SIG_IGN);
+    if (host) {
+        int listener = openServerSocket(address, true);
+        if (listener < 0) return false;
+        std::cout << "Waiting for the cat player on " << spec.substr(5) << "...\n";
+        versus.socket = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        close(listener);
+        if (!address.tcp) unlinkStaleSocket(address.path);
     } else {
-        // Window is taller than the game (letterbox)
-        newViewportW = w;
-        newViewportH = (int)(w / gameAspect);
-        newViewportX = 0;
-        newViewportY = (h - newViewportH) / 2;
+        versus.socket = openServerSocket(address, false);
     }
-    glViewport(newViewportX, newViewportY, newViewportW, newViewportH);
-    glutPostRedisplay();
+    if (versus.socket < 0) return false;
+    setNonBlocking(versus.socket);
+    versus.catSide = !host;
+    versus.latencyMs = latencyMs;
+    versusMode = true;
+    if (host) {
+        uint32_t seed = (uint32_t)time(0) | 1u;
+        uint8_t options = optimizeItemPlacement ? VERSUS_OPTIMIZED_PLACEMENT : 0;
+        versusSend(versus, {VERSUS_HELLO, options, 0, seed});
+        versusStart(versus, seed, options);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief --versus-bot=<seconds>: plays this side headless with random keys for a fixed
+ * number of ticks, then prints the final state hash, which must match the other side's.
+ */
+int runVersusBot(int seconds) {
+    std::mt19937 rng(versus.catSide ? 2 : 1);
+    versus.endTick = (uint32_t)seconds * 1000 / VERSUS_TICK_MS;
+    bool changed;
+    engineLog = false;
+    while (versus.startMs == 0 || versus.tick < versus.endTick || versus.remoteTicks < versus.endTick || !versusFlush(versus)) {
+        if (rng() % 30 == 0) versus.pendingInput = rng() % 4; // A key every 30 ms or so.
+        if (!versusPump(versus, changed)) { std::cout << "Opponent left at tick " << versus.tick << ".\n"; return 1; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    engineLog = true;
+    printVersusStats(versus);
+    std::cout << "[versus] " << (versus.catSide ? "cat" : "mouse") << " side final state at tick " << versus.tick << ": level " << currentLevel
+              << ", score " << totalScore + score << ", hash " << std::hex << gameStateHash << std::dec << "\n";
+    return 0;
 }
 
+/**
+ * @brief Plays the mouse side against scripted cat inputs that arrive `delay` ticks late,
+ * timing the rollbacks, and checks the result matches a run where every input was on time.
+ */
+void benchRollback(int ticks, std::mt19937& rng) {
+    std::vector<uint8_t> mouse(ticks), cat(ticks);
+    for (int t = 0; t < ticks; ++t) {
+        mouse[t] = (rng() % 3 == 0) ? rng() % 4 : CHASE_ACTION_STAY;
+        cat[t] = (rng() % 8 == 0) ? rng() % 4 : CHASE_ACTION_STAY;
+    }
+    for (int delay : {3, 10, VERSUS_MAX_AHEAD - 1}) {
+        auto reference = std::make_unique<VersusSession>(), session = std::make_unique<VersusSession>();
+        GameSnapshot expected;
+        double totalMs;
+        {
+            engineLog = false;
+            versusStart(*reference, 12345);
+            for (int t = 0; t < ticks; ++t) {
+                reference->localInputs[t % VERSUS_HISTORY] = mouse[t];
+                versusReceiveInput(*reference, cat[t]);
+                versusSimulate(*reference, reference->tick++);
+            }
+            snapshotGame(expected);
+
+            versusStart(*session, 12345);
+            auto t0 = std::chrono::steady_clock::now();
+            for (int t = 0; t < ticks + delay; ++t) {
+                if (t >= delay) versusReceiveInput(*session, cat[t - delay]);
+                if (session->rollbackFrom != UINT32_MAX) versusRollback(*session);
+                if (t >= ticks) continue;
+                session->localInputs[t % VERSUS_HISTORY] = mouse[t];
+                versusSimulate(*session, session->tick++);
+            }
+            totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            engineLog = true;
+        }
+        bool identical = memcmp(&expected, &liveGame, sizeof(GameSnapshot)) == 0;
+        long long rollbacks = std::max(1LL, session->rollbacks);
+        std::cout << "Rollback, inputs " << delay << " ticks late: " << ticks << " ticks in " << totalMs << " ms, " << session->rollbacks << " rollbacks of "
+                  << (double)session->resimulatedTicks / rollbacks << " ticks average, " << session->rollbackUsSum / rollbacks << " us average, "
+                  << session->rollbackUsMax << " us max; " << (identical ? "matches" : "DIVERGES FROM") << " on-time play\n";
+    }
+}
 
 // -----------------------------------------------------------------------------
 // MAIN FUNCTION
 // -----------------------------------------------------------------------------
 
+#ifndef CHASE_LIBRARY
 int main(int argc, char** argv) {
-    srand(time(0)); // Seed the random number generator
+    initZobristKeys();
+    std::string recordPath, replayPath, connectAddress, versusSpec;
+    int latencyMs = 0, versusBotSeconds = 0;
+    uint32_t watchSession = 0;
+    if (argc > 1 && std::string(argv[1]) == "--bench") return runBenchmarks(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--solve-tablebase") return runTablebaseSolver(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--tune-difficulty") return runDifficultyTuner(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--analyze-replays") return runReplayAnalytics(argc, argv);
+    if (argc > 2 && std::string(argv[1]) == "--serve-bots") {
+        return runServerBots(argv[2], (argc > 3) ? std::max(1, atoi(argv[3])) : 1000, (argc > 4) ? std::max(1, atoi(argv[4])) : 10);
+    }
+    if (argc > 2 && std::string(argv[1]) == "--serve-spectators") {
+        return runServerSpectators(argv[2], (argc > 3) ? std::max(1, atoi(argv[3])) : 10000, (argc > 4) ? std::max(1, atoi(argv[4])) : 10);
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--pathfinder=bfs") catPathfinder = PATHFINDER_BFS;
+        else if (arg == "--pathfinder=junction") catPathfinder = PATHFINDER_JUNCTION;
+        else if (arg == "--pathfinder=hpa") catPathfinder = PATHFINDER_HPA;
+        else if (arg == "--pathfinder=dstar") catPathfinder = PATHFINDER_DSTAR;
+        else if (arg == "--pathfinder=bidirectional") catPathfinder = PATHFINDER_BIDIRECTIONAL;
+        else if (arg == "--pathfinder=predictive") catPathfinder = PATHFINDER_PREDICTIVE;
+        else if (arg == "--pathfinder=tablebase") catPathfinder = PATHFINDER_TABLEBASE;
+        else if (arg == "--placement=optimized") optimizeItemPlacement = true;
+        else if (arg.rfind("--record=", 0) == 0) recordPath = arg.substr(9);
+        else if (arg.rfind("--replay=", 0) == 0) replayPath = arg.substr(9);
+        else if (arg.rfind("--connect=", 0) == 0) connectAddress = arg.substr(10);
+        else if (arg.rfind("--watch=", 0) == 0) watchSession = strtoul(arg.c_str() + 8, nullptr, 10);
+        else if (arg.rfind("--versus=", 0) == 0) versusSpec = arg.substr(9);
+        else if (arg.rfind("--versus-bot=", 0) == 0) versusBotSeconds = std::max(1, atoi(arg.c_str() + 13));
+        else if (arg.rfind("--latency=", 0) == 0) latencyMs = std::max(0, atoi(arg.c_str() + 10));
+        else if (arg.rfind("--ambushers=", 0) == 0) {
+            std::stringstream list(arg.substr(12));
+            std::string name;
+            while (std::getline(list, name, ',') && (int)ambusherPersonalities.size() < MAX_AMBUSHERS) {
+                int personality = std::find(PERSONALITY_NAMES, PERSONALITY_NAMES + PERSONALITY_COUNT, name) - PERSONALITY_NAMES;
+                if (personality < PERSONALITY_COUNT) ambusherPersonalities.push_back((ChaserPersonality)personality);
+                else std::cout << "Unknown ambusher personality: " << name << "\n";
+            }
+        }
+    }
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        loadDifficultyFile(DIFFICULTY_FILE);
+        return runGameServer(argv[2], (argc > 3 && argv[3][0] != '-') ? atoi(argv[3]) : 0);
+    }
+    loadDifficultyFile(DIFFICULTY_FILE);
+    liveGame.randomState = static_cast<uint32_t>(time(0)) | 1u; // Seed the game RNG (xorshift needs a nonzero state)
+    if (!replayPath.empty()) {
+        if (!openReplay(replayViewer, replayPath)) { std::cout << "Could not open replay " << replayPath << "\n"; return 1; }
+        catPathfinder = (CatPathfinder)replayViewer.header.pathfinder;
+        std::copy(replayViewer.header.speedCurves, replayViewer.header.speedCurves + MAX_LEVELS + 1, levelSpeedCurves);
+        viewingReplay = true;
+        std::cout << "Replay " << replayPath << ": " << replayViewer.tickCount << " events, " << replayViewer.index.size() << " keyframes.\n";
+    } else if (!versusSpec.empty()) {
+        if (!startVersus(versusSpec, latencyMs)) { std::cout << "Could not start versus play on " << versusSpec << " (use host:<address> or join:<address>)\n"; return 1; }
+        std::cout << "Versus play: you are the " << (versus.catSide ? "cat" : "mouse") << ".\n";
+        if (versusBotSeconds > 0) return runVersusBot(versusBotSeconds);
+    } else if (!connectAddress.empty()) {
+        if (!startNetworkClient(connectAddress, watchSession)) { std::cout << "Could not connect to " << connectAddress << "\n"; return 1; }
+        std::cout << "Connected to " << connectAddress << ".\n";
+    } else if (!recordPath.empty()) {
+        if (replayBeginRecording(liveRecording, recordPath)) atexit([]() { replayFinishRecording(liveRecording); });
+        else std::cout << "Could not create replay " << recordPath << "\n";
+    }
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_ALPHA | GLUT_MULTISAMPLE);
     glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     glutInitWindowPosition(100, 100);
     glutCreateWindow("Cat and Mouse - The Grand Chase!");
 
+    if (viewingReplay) {
+        initOpenGL();
+        glutDisplayFunc(display);
+        glutReshapeFunc(reshape);
+        glutKeyboardFunc(keyboard);
+        glutSpecialFunc(specialKeyboard);
+        replayViewerSeek(0);
+        std::cout << "\n--- Replay Controls ---\nSpace: Play/Pause\nLeft/Right: Step\nUp/Down: 100 events\nPage Up/Down: 10000 events\nHome/End: Start/End\nESC: Quit\n-----------------------\n";
+        glutMainLoop();
+        return 0;
+    }
+    if (networkClient) {
+        initOpenGL();
+        glutDisplayFunc(display);
+        glutReshapeFunc(reshape);
+        glutKeyboardFunc(keyboard);
+        glutSpecialFunc(specialKeyboard);
+        glutIdleFunc(networkClientIdle);
+        if (networkWatching) std::cout << "\nWatching session " << watchSession << ". ESC: Quit\n";
+        else std::cout << "\n--- Network Controls ---\nWASD or Arrow Keys: Move\nR or Enter: New Game\nESC: Quit\n------------------------\n";
+        glutMainLoop();
+        return 0;
+    }
+    if (versusMode) {
+        initOpenGL();
+        glutDisplayFunc(display);
+        glutReshapeFunc(reshape);
+        glutKeyboardFunc(keyboard);
+        glutSpecialFunc(specialKeyboard);
+        glutIdleFunc(versusIdle);
+        std::cout << "\n--- Versus Controls ---\nWASD or Arrow Keys: " << (versus.catSide ? "Steer the cat" : "Move") << "\nESC: Quit\n-----------------------\n";
+        glutMainLoop();
+        return 0;
+    }
+
     // A timer to automatically transition from the intro screen to the start menu
     glutTimerFunc(3500, [](int val){
         if (currentGameState == INTRO) {
@@ -963,6 +7678,7 @@ int main(int argc, char** argv) {
     glutSpecialFunc(specialKeyboard); // Register the handler for arrow keys
     glutIdleFunc(idle);
     lastTickTime = glutGet(GLUT_ELAPSED_TIME);
+    predictiveInBackground = true; // Headless modes keep the search on the calling thread.
 /*
     // Check for and report MSAA (anti-aliasing) status
     GLint buffers; GLint samples;
@@ -977,3 +7693,4 @@ int main(int argc, char** argv) {
     glutMainLoop();
     return 0;
 }
+#endif // CHASE_LIBRARY